@@ -25,7 +25,12 @@ void Axis::setup(const int& pwmPin, const int& directionPin1, const int& directi
     float one = 1.0;
     _Kp = _Ki = _Kd = &zero;
     
-    motorGearboxEncoder.setup(pwmPin, directionPin1, directionPin2, encoderPin1, encoderPin2, loopInterval);
+    //the PID loops of this axis chosen by FIXEDPOSITIONPID and FIXEDVELOCITYPID run in fixed point
+    byte pidAxis = (axisName == 'L') ? LEFTAXISPID : (axisName == 'R') ? RIGHTAXISPID : ZAXISPID;
+    motorGearboxEncoder.setup(pwmPin, directionPin1, directionPin2, encoderPin1, encoderPin2, loopInterval / VELOCITYLOOPS, FIXEDVELOCITYPID & pidAxis);
+    #if FIXEDPOSITIONPID > 0
+    _pidController.useFixedPoint(FIXEDPOSITIONPID & pidAxis);
+    #endif
     _pidController.setup(&_pidInput, &_pidOutput, &_pidSetpoint, _Kp, _Ki, _Kd, &one, REVERSE);
     
     //initialize variables
@@ -43,27 +48,27 @@ void   Axis::initializePID(const unsigned long& loopInterval){
 }
 
 void    Axis::write(const float& targetPosition){
-    _timeLastMoved = millis();
-    _pidSetpoint   =  targetPosition/ *_mmPerRotation;
+    _setTimeLastMoved();
+    _setSetpoint(_toSetpoint(targetPosition));
     return;
 }
 
 float  Axis::read(){
     //returns the true axis position
     
-    return (motorGearboxEncoder.encoder.read()/ *_encoderSteps) * *_mmPerRotation;
+    return motorGearboxEncoder.encoder.read() * _mmPerStep;
     
 }
 
 float  Axis::setpoint(){
-    return _pidSetpoint * *_mmPerRotation;
+    return _getSetpoint() * _mmPerPIDUnit;
 }
 
 void   Axis::set(const float& newAxisPosition){
     
     //reset everything to the new value
-    _pidSetpoint  =  newAxisPosition/ *_mmPerRotation;
-    motorGearboxEncoder.encoder.write((newAxisPosition * *_encoderSteps)/ *_mmPerRotation);
+    _setSetpoint(_toSetpoint(newAxisPosition));
+    motorGearboxEncoder.encoder.write(newAxisPosition * _stepsPerMM);
     
 }
 
@@ -77,18 +82,52 @@ long Axis::steps(){
 void   Axis::setSteps(const long& steps){
     
     //reset everything to the new value
-    _pidSetpoint  =  steps/ *_encoderSteps;
+    #if STEPPOSITIONPID > 0
+    _setSetpoint(steps);
+    #else
+    _setSetpoint(steps * _pidUnitsPerStep);
+    #endif
     motorGearboxEncoder.encoder.write(steps);
     
 }
 
 void   Axis::computePID(){
+    /*
+    Runs the position PID loop, which sets the speed the motor should turn at.
+    Called every LOOPINTERVAL after motorGearboxEncoder.snapshotEncoder().
+    */
+    if (_disableAxisForTesting || !motorGearboxEncoder.motor.attached()){
+        return;
+    }
+    
+    #if STEPPOSITIONPID > 0
+    //the PID works in floating point, which holds whole numbers of steps exactly
+    //up to 2^24, so converting the counts here loses nothing
+    _pidSetpoint   =  _stepSetpoint;
+    _pidInput      =  motorGearboxEncoder.encoderSnapshot.position;
+    #else
+    _pidInput      =  motorGearboxEncoder.encoderSnapshot.position * _pidUnitsPerStep;
+    #endif
+    
+    if (_pidController.Compute()){
+        // Only write output if the PID calculation was performed
+        motorGearboxEncoder.write(_pidOutput);
+    }
+    
+}
+
+void   Axis::computeVelocityPID(){
+    /*
+    Runs the motor speed PID loop, which drives the motor at the speed set by
+    the position loop.  Called every VELOCITYLOOPINTERVAL after
+    motorGearboxEncoder.snapshotEncoder().
+    */
     
     #ifdef FAKE_SERVO
       if (motorGearboxEncoder.motor.attached()){
         // Adds up to 10% error just to simulate servo noise
         double rpm = (-1 * _pidOutput) * random(90, 110) / 100;
-        unsigned long steps = motorGearboxEncoder.encoder.read() + round( rpm * *_encoderSteps * LOOPINTERVAL)/(60 * 1000000);
+        unsigned long steps = motorGearboxEncoder.encoder.read() + round( rpm * *_encoderSteps * VELOCITYLOOPINTERVAL)/(60 * 1000000);
         motorGearboxEncoder.encoder.write(steps);
       }
     #endif
@@ -97,13 +136,6 @@ void   Axis::computePID(){
         return;
     }
     
-    _pidInput      =  motorGearboxEncoder.encoder.read()/ *_encoderSteps;
-    
-    if (_pidController.Compute()){
-        // Only write output if the PID calculation was performed
-        motorGearboxEncoder.write(_pidOutput);
-    }
-    
     motorGearboxEncoder.computePID();
     
 }
@@ -129,8 +161,9 @@ void   Axis::setPIDValues(float* KpPos, float* KiPos, float* KdPos, float* propW
     _Kp = KpPos;
     _Ki = KiPos;
     _Kd = KdPos;
+    _propWeight = propWeight;
     
-    _pidController.SetTunings(_Kp, _Ki, _Kd, propWeight);
+    _setTunings();
     
     motorGearboxEncoder.setPIDValues(KpV, KiV, KdV, propWeightV);
 }
@@ -158,9 +191,13 @@ void   Axis::setPIDAggressiveness(float aggressiveness){
 
 float  Axis::error(){
 
-    float encoderErr = (motorGearboxEncoder.encoder.read()/ *_encoderSteps) - _pidSetpoint;
+    #if STEPPOSITIONPID > 0
+    return (motorGearboxEncoder.encoder.read() - _getSetpoint()) * _mmPerStep;
+    #else
+    float encoderErr = (motorGearboxEncoder.encoder.read() * _pidUnitsPerStep) - _getSetpoint();
 
-    return encoderErr * *_mmPerRotation;
+    return encoderErr * _mmPerPIDUnit;
+    #endif
 }
 
 void   Axis::changePitch(float *newPitch){
@@ -168,6 +205,7 @@ void   Axis::changePitch(float *newPitch){
     Reassign the distance moved per-rotation for the axis.
     */
     _mmPerRotation = newPitch;
+    _updateScales();
 }
 
 float  Axis::getPitch(){
@@ -182,12 +220,64 @@ void   Axis::changeEncoderResolution(float *newResolution){
     Reassign the encoder resolution for the axis.
     */
     _encoderSteps = newResolution;
+    _updateScales();
     
     //push to the gearbox for calculating RPM
     motorGearboxEncoder.setEncoderResolution(*newResolution);
     
 }
 
+void   Axis::_updateScales(){
+    /*
+    Works out the conversions between mm, encoder steps and the units of the
+    position PID, rotations or with STEPPOSITIONPID encoder steps, so that
+    moving the axis takes no divisions.  Must be called whenever the pitch or
+    encoder resolution changes.  The timer interrupt uses these, so it is held
+    off while they change.
+    */
+    if (_mmPerRotation == NULL || _encoderSteps == NULL){
+        return;  // not set up yet
+    }
+    float mmPerStep = *_mmPerRotation / *_encoderSteps;
+    byte oldSREG = SREG;
+    cli();
+    _mmPerStep        = mmPerStep;
+    _stepsPerMM       = 1.0 / mmPerStep;
+    #if STEPPOSITIONPID > 0
+    _pidUnitsPerMM    = _stepsPerMM;
+    _mmPerPIDUnit     = mmPerStep;
+    _pidUnitsPerStep  = 1.0;
+    #else
+    _pidUnitsPerMM    = 1.0 / *_mmPerRotation;
+    _mmPerPIDUnit     = *_mmPerRotation;
+    _pidUnitsPerStep  = 1.0 / *_encoderSteps;
+    #endif
+    SREG = oldSREG;
+    
+    #if STEPPOSITIONPID > 0
+    if (_propWeight != NULL){
+        _setTunings();   // the gains are per step, so they change with the resolution
+    }
+    #endif
+}
+
+void   Axis::_setTunings(){
+    /*
+    Gives the position PID its gains, which are set in RPM per rotation the
+    axis is away from its setpoint.  With STEPPOSITIONPID they are scaled to
+    RPM per encoder step.
+    */
+    #if STEPPOSITIONPID > 0
+    float rotationsPerStep = 1.0 / *_encoderSteps;
+    _KpSteps = *_Kp * rotationsPerStep;
+    _KiSteps = *_Ki * rotationsPerStep;
+    _KdSteps = *_Kd * rotationsPerStep;
+    _pidController.SetTunings(&_KpSteps, &_KiSteps, &_KdSteps, _propWeight);
+    #else
+    _pidController.SetTunings(_Kp, _Ki, _Kd, _propWeight);
+    #endif
+}
+
 int    Axis::detach(){
     
     motorGearboxEncoder.motor.detach();
@@ -213,9 +303,14 @@ bool   Axis::attached(){
 void   Axis::detachIfIdle(){
     /*
     Detaches the axis, turning off the motor and PID control, if it has been
-    stationary for more than axisDetachTime
+    stationary for more than axisDetachTime.  write() updates the time the axis
+    last moved from the timer interrupt, so it is read with interrupts held off
     */
-    if (millis() - _timeLastMoved > sysSettings.axisDetachTime){
+    byte oldSREG = SREG;
+    cli();
+    unsigned long timeLastMoved = _timeLastMoved;
+    SREG = oldSREG;
+    if (millis() - timeLastMoved > sysSettings.axisDetachTime){
         detach();
     }
     
@@ -223,8 +318,8 @@ void   Axis::detachIfIdle(){
 
 void   Axis::endMove(const float& finalTarget){
     
-    _timeLastMoved = millis();
-    _pidSetpoint    = finalTarget/ *_mmPerRotation;
+    _setTimeLastMoved();
+    _setSetpoint(_toSetpoint(finalTarget));
     
 }
 
@@ -235,8 +330,12 @@ void   Axis::stop(){
 
     */
 
-    _timeLastMoved = millis();
-    _pidSetpoint   = read()/ *_mmPerRotation;
+    _setTimeLastMoved();
+    #if STEPPOSITIONPID > 0
+    _setSetpoint(motorGearboxEncoder.encoder.read());
+    #else
+    _setSetpoint(read() * _pidUnitsPerMM);
+    #endif
 
 }
 
@@ -297,5 +396,62 @@ void   Axis::test(){
     Serial.print(F("<Idle,MPos:0,0,0,WPos:0.000,0.000,0.000>"));
 }
 
-double  Axis::pidInput(){ return _pidInput * *_mmPerRotation;}
+axisSetpoint_t Axis::_toSetpoint(const float& position){
+    /*
+    Converts a position in mm to the units of the PID setpoint, rounded to a whole
+    encoder step with STEPPOSITIONPID
+    */
+    #if STEPPOSITIONPID > 0
+    return lround(position * _stepsPerMM);
+    #else
+    return position * _pidUnitsPerMM;
+    #endif
+}
+
+void   Axis::_setSetpoint(const axisSetpoint_t& setpoint){
+    /*
+    Changes the PID setpoint.  The setpoint is read by the PID loop in the timer
+    interrupt and takes more than one instruction to write, so interrupts are held
+    off while it changes.  The interrupt state is put back how it was found because
+    runsOnATimer() calls this too.
+    */
+    byte oldSREG = SREG;
+    cli();
+    #if STEPPOSITIONPID > 0
+    _stepSetpoint = setpoint;
+    #else
+    _pidSetpoint = setpoint;
+    #endif
+    SREG = oldSREG;
+}
+
+void   Axis::_setTimeLastMoved(){
+    /*
+    Records when the axis was last told to move.  write() does this from the timer
+    interrupt while endMove() and stop() do it from the main loop, so interrupts are
+    held off for the four byte write
+    */
+    unsigned long now = millis();
+    byte oldSREG = SREG;
+    cli();
+    _timeLastMoved = now;
+    SREG = oldSREG;
+}
+
+axisSetpoint_t Axis::_getSetpoint(){
+    /*
+    Reads the PID setpoint without the timer interrupt being able to change it part way
+    */
+    byte oldSREG = SREG;
+    cli();
+    #if STEPPOSITIONPID > 0
+    axisSetpoint_t setpoint = _stepSetpoint;
+    #else
+    axisSetpoint_t setpoint = _pidSetpoint;
+    #endif
+    SREG = oldSREG;
+    return setpoint;
+}
+
+double  Axis::pidInput(){ return _pidInput * _mmPerPIDUnit;}
 double  Axis::pidOutput(){ return _pidOutput;}
@@ -18,6 +18,12 @@
     #ifndef Axis_h
     #define Axis_h
 
+    #if STEPPOSITIONPID > 0
+    typedef int32_t axisSetpoint_t;     // the position PID setpoint, in whole encoder steps
+    #else
+    typedef double  axisSetpoint_t;     // the position PID setpoint, in rotations
+    #endif
+
     class Axis{
         public:
             void   setup(const int& pwmPin, const int& directionPin1, const int& directionPin2, const int& encoderPin1, const int& encoderPin2, const char& axisName, const unsigned long& loopInterval);
@@ -36,6 +42,7 @@
             float  error();
             float  setpoint();
             void   computePID();
+            void   computeVelocityPID();
             void   disablePositionPID();
             void   enablePositionPID();
             void   setPIDAggressiveness(float aggressiveness);
@@ -55,14 +62,36 @@
             int        _PWMread(int pin);
             void       _writeFloat(const unsigned int& addr, const float& x);
             float      _readFloat(const unsigned int& addr);
-            unsigned long   _timeLastMoved;
+            void       _setSetpoint(const axisSetpoint_t& setpoint);
+            axisSetpoint_t _getSetpoint();
+            axisSetpoint_t _toSetpoint(const float& position);
+            void       _setTimeLastMoved();
+            void       _updateScales();
+            void       _setTunings();
+            volatile unsigned long _timeLastMoved;   // written by write() in the timer interrupt
             volatile double _pidSetpoint;
+            #if STEPPOSITIONPID > 0
+            volatile int32_t _stepSetpoint;   // copied to _pidSetpoint each time the PID loop runs
+            #endif
             volatile double _pidInput; 
             volatile double _pidOutput;
             float      *_Kp, *_Ki, *_Kd;
+            #if FIXEDPOSITIONPID > 0
+            SelectablePID _pidController;
+            #else
             PID        _pidController;
+            #endif
             float      *_mmPerRotation;
             float      *_encoderSteps;
+            float      _mmPerStep;          // worked out from the two above by _updateScales()
+            float      _stepsPerMM;
+            float      _pidUnitsPerMM;
+            float      _mmPerPIDUnit;
+            float      _pidUnitsPerStep;
+            float      *_propWeight;
+            #if STEPPOSITIONPID > 0
+            float      _KpSteps, _KiSteps, _KdSteps;   // the gains scaled to encoder steps
+            #endif
             bool       _disableAxisForTesting = false;
             char       _axisName;
     };
@@ -24,6 +24,9 @@
                            // to complete before being interrupted, helpful for loop
                            // LOOPINTERVAL tuning
 #define KINEMATICSDBG 0    // set to 1 for additional kinematics debug messaging
+#define PROFILING 0        // set to 1 to time each part of the control loop, the
+                           // times are sent by the $P command.  Costs a little
+                           // time on every step and 130 bytes of RAM.
 
 // #define FAKE_SERVO      // Uncomment this line to cause the Firmware to mimic
                            // a servo updating the encoder steps even if no servo
@@ -33,7 +36,81 @@
                            // simulator. Normally, you would not define this directly, but
                            // use PlatformIO to build the simavr environment.
 
-#define LOOPINTERVAL 10000 // What is the frequency of the PID loop in microseconds
+#ifndef KINEMATICSCACHE
+#define KINEMATICSCACHE 0  // set to 1 to answer the quadrilateral inverse kinematics
+                           // from a table of chain lengths interpolated across the
+                           // sheet instead of solving them on every step.  The table
+                           // is rebuilt while idle whenever the machine geometry
+                           // changes and takes 2323 bytes of RAM on the Mega whether
+                           // or not it is used.  The triangular kinematics are quick
+                           // enough on their own and never use it.  The native
+                           // benchmark is always built with it.
+#endif
+
+#define KINEMATICSFASTTRIG 1 // set to 0 to use the library atan2() in the triangular
+                             // kinematics instead of a polynomial approximation
+                             // which is faster.  Either way the chain lengths are
+                             // within 0.0008mm of a double precision solution across
+                             // the sheet, 0.0007mm measured with it and 0.0006mm without.
+
+#define LOOPINTERVAL 10000 // What is the frequency of the position PID loop in microseconds,
+                           // a new setpoint is sent to the axes this often
+#define VELOCITYLOOPS 1    // The number of times the motor speed PID loop runs for each
+                           // run of the position PID loop.  The timer interrupt runs
+                           // every LOOPINTERVAL / VELOCITYLOOPS, which must be a whole
+                           // number of milliseconds.  Left at 1 the speed loop runs
+                           // at the same rate as before, so a faster speed loop is
+                           // opt-in.  Its cost on a Mega has not been measured: each
+                           // extra run adds a pass of the three speed PID loops to
+                           // the timer interrupt, so turn on PROFILING and check the
+                           // velocity PID time in $P fits before raising it.
+#define VELOCITYLOOPINTERVAL (LOOPINTERVAL / VELOCITYLOOPS)
+#if VELOCITYLOOPINTERVAL * VELOCITYLOOPS != LOOPINTERVAL || VELOCITYLOOPINTERVAL % 1000 != 0
+  #error "LOOPINTERVAL / VELOCITYLOOPS must be a whole number of milliseconds"
+#endif
+#define SPEEDWINDOW 3      // The motor speed is measured between the encoder steps
+                           // seen by the speed loop this many runs apart, less one.
+                           // Longer is smoother but slower to respond.  Each one
+                           // uses 24 bytes of RAM.
+#define STEPPOSITIONPID 0  // set to 1 to run the position PID loops in encoder steps
+                           // instead of rotations, which saves converting the encoder
+                           // position every time they run.  The setpoint is then kept
+                           // as a whole number of steps, which stays exact however
+                           // far the chain is let out.  Can't be used with
+                           // FIXEDPOSITIONPID, the step counts are too large for it.
+#define LEFTAXISPID  1     // The axes for FIXEDPOSITIONPID and FIXEDVELOCITYPID, add
+#define RIGHTAXISPID 2     // them together to choose more than one, eg
+#define ZAXISPID     4     // (LEFTAXISPID + RIGHTAXISPID) for both chains.
+#define FIXEDPOSITIONPID 0 // the axes whose position PID loops run in fixed point
+#define FIXEDVELOCITYPID 0 // the axes whose motor speed PID loops run in fixed point,
+                           // which leaves less floating point maths in the timer
+                           // interrupt.  Any axis chosen costs each axis the RAM of
+                           // a second controller.  The native checks compare the two.
+#if STEPPOSITIONPID > 0 && FIXEDPOSITIONPID > 0
+  #error "STEPPOSITIONPID and FIXEDPOSITIONPID can't be used together"
+#endif
+
+// Motion planner
+#define SETPOINTQUEUESIZE 8           // The number of PID loop setpoints which can be
+                                      // worked out ahead of time.  Each one uses 14
+                                      // bytes of RAM.
+#define PLANNERBUFFERSIZE 8           // The number of moves the planner can look ahead
+                                      // through.  Each one uses 40 bytes of RAM.
+#define PLANNERACCELERATION 100.0     // Acceleration used to plan moves in mm/s^2
+#define PLANNERJUNCTIONDEVIATION 0.05 // How far in mm the path may be allowed to cut
+                                      // a corner between two moves.  Larger values
+                                      // carry more speed through corners.
+#define ADAPTIVESTEPS 0               // set to 1 to work out the chain lengths only as
+                                      // often as needed while cruising along a straight
+                                      // move, with the PID loop moving the chains evenly
+                                      // in between.  Long moves need far fewer kinematics
+                                      // calculations.
+#define ADAPTIVETOLERANCE 0.01        // How far in mm the chain lengths may be from the
+                                      // exact ones in between
+#define ARCCORRECTION 12              // The number of arc steps made by rotating the
+                                      // last point before it is worked out again
+                                      // exactly with sin() and cos(), so one step
+                                      // in every ARCCORRECTION + 1 uses them
 
 // Define version detect pins
 #define VERS1 22
@@ -44,8 +121,10 @@
 #define VERS6 27
 
 // Serial variables
-#define INCBUFFERLENGTH 128 // The number of bytes(characters) allocated to the
-                            // incoming buffer.
+#define INCBUFFERLENGTH 256 // The number of bytes(characters) allocated to the
+                            // incoming buffer.  One less than this can be used,
+                            // which is reported to the host on start up and, in
+                            // streaming mode ($S=1), with every ok.
 #define EXPGCODELINE 60     // Maximum expected Gcode line length in characters
                             // including line ending character(s).  Assumes
                             // client will not send more than this.  Ground
@@ -60,5 +139,10 @@
                             // a larger number make position updates in GC less
                             // smooth.  This is only a minimum, and the actual
                             // timeout could be significantly larger.
+#define MINSTATUSFRAMEINTERVAL 20 // The shortest time in milliseconds allowed between
+                                  // the status frames turned on by $F.  Each frame
+                                  // takes about 8ms to send at 57600 baud.
+#define MAXSTATUSFRAMEINTERVAL 65535 // The longest, which is all sys.statusFrameInterval
+                                     // can hold on the Mega.
 
 #endif
@@ -7,4 +7,5 @@
 
 Encoder_internal_state_t * Encoder::interruptArgs[];
 
-
+// The change in position for each state in update(), from the table of states in Encoder.h
+const int8_t Encoder::stepTable[16] = {0, 1, -1, 2, -1, 0, -2, 1, 1, -2, 0, -1, 2, -1, 1, 0};
@@ -66,6 +66,13 @@ typedef struct {
 	int32_t							   lastTime;
 } Encoder_internal_state_t;
 
+// A copy of an encoder's position and step times, all as of the same step
+typedef struct {
+	int32_t position;
+	int32_t lastTime;       // micros() at the last step
+	int32_t elapsedTime;    // time between the last two steps, negative when going backwards
+} encoderSnapshot_t;
+
 class Encoder
 {
 public:
@@ -134,6 +141,16 @@ public:
 		interrupts();
 		return ret;
 	}
+	// Copies the position and step times.  Interrupts must already be off,
+	// which lets several encoders be read together.
+	inline void snapshot(encoderSnapshot_t *steps) {
+		if (interrupts_in_use < 2) {
+			update(&encoder);
+		}
+		steps->position = encoder.position;
+		steps->lastTime = encoder.lastTime;
+		steps->elapsedTime = encoder.elapsedTime;
+	}
 	inline void write(int32_t p) {
 		noInterrupts();
 		encoder.position = p;
@@ -155,6 +172,7 @@ private:
 #endif
 public:
 	static Encoder_internal_state_t * interruptArgs[ENCODER_ARGLIST_SIZE];
+	static const int8_t stepTable[16];
 
 //                           _______         _______       
 //               Pin1 ______|       |_______|       |______ Pin1
@@ -300,27 +318,18 @@ private:
 		if (p1val) state |= 4;
 		if (p2val) state |= 8;
 		arg->state = (state >> 2);
-		switch (state) {
-			case 1: case 7: case 8: case 14:
-				arg->position++;
-				arg->elapsedTime = (micros() - arg->lastTime);
-				arg->lastTime = micros();
-				return;
-			case 2: case 4: case 11: case 13:
-				arg->position--;
-				arg->elapsedTime = (arg->lastTime - micros());
-				arg->lastTime = micros();
-				return;
-			case 3: case 12:
-				arg->position += 2;
-				arg->elapsedTime = (micros() - arg->lastTime) >> 1;
-				arg->lastTime = micros();
-				return;
-			case 6: case 9:
-				arg->position -= 2;
-				arg->elapsedTime = (arg->lastTime - micros()) >> 1;
-				arg->lastTime = micros();
-				return;
+		// The change is looked up in stepTable, which follows the table of
+		// states above, and micros() is read once.  Time is measured per
+		// step so a double step halves it.
+		int8_t change = stepTable[state];
+		if (change != 0) {
+			uint32_t now = micros();
+			int32_t elapsed = now - arg->lastTime;
+			if (change < 0) elapsed = -elapsed;
+			if (change == 2 || change == -2) elapsed /= 2;
+			arg->position += change;
+			arg->elapsedTime = elapsed;
+			arg->lastTime = now;
 		}
 #endif
 	}
@@ -36,7 +36,9 @@ void readSerialCommands(){
     /*
     Check to see if a new character is available from the serial connection,
     if this is a necessary character write to the incSerialBuffer otherwise discard
-    it.
+    it.  '!' and '~' act straight away and never reach the buffer, so in streaming
+    mode they are not acknowledged, a host counting characters would take the 'ok'
+    as the reply to the oldest line it sent and overfill the buffer.
     */
 
     static bool quickCommandFlag = false;
@@ -48,12 +50,16 @@ void readSerialCommands(){
                 sys.stop = true;
                 quickCommandFlag = true;
                 bit_false(sys.pause, PAUSE_FLAG_USER_PAUSE);
-                reportStatusMessage(STATUS_OK);
+                if (!sys.streaming){
+                    reportStatusMessage(STATUS_OK);
+                }
             }
             else if (c == '~'){
                 quickCommandFlag = true;
                 bit_false(sys.pause, PAUSE_FLAG_USER_PAUSE);
-                reportStatusMessage(STATUS_OK);
+                if (!sys.streaming){
+                    reportStatusMessage(STATUS_OK);
+                }
             }
             else if (quickCommandFlag and c == '\n'){
               // Catch line ending and ignore after quick commands
@@ -76,43 +82,78 @@ void readSerialCommands(){
     }
 }
 
-int   findEndOfNumber(const String& textString, const int& index){
-    //Return the index of the last digit of the number beginning at the index passed in
-    unsigned int i = index;
+float extractGcodeValue(const String& readString, char target, const float& defaultReturn){
 
-    while (i < textString.length()){
+    /*Reads a string and returns the value of number following the target character.
+    If no number is found, defaultReturn is returned*/
 
-        if(isDigit(textString[i]) or isPunct(textString[i])){ //If we're still looking at a number, keep goin
-            i++;
-        }
-        else{
-            return i;                                         //If we've reached the end of the number, return the last index
-        }
+    int begin = readString.indexOf(target);
+
+    if (begin == -1){ //if the character was not found, return error
+        return defaultReturn;
     }
-    return i;                                                 //If we've reached the end of the string, return the last number
+
+    byte  index = begin + 1;
+    return readGcodeNumber(readString.c_str(), index);
 }
 
-float extractGcodeValue(const String& readString, char target, const float& defaultReturn){
+float readGcodeNumber(const char* line, byte& index){
 
-    /*Reads a string and returns the value of number following the target character.
-    If no number is found, defaultReturn is returned*/
+    /*Returns the number starting at index and moves index past it, or returns 0 if there
+    is no number there.  Unlike readFloat() this will not step over a letter to find one.*/
 
-    int begin;
-    int end;
-    String numberAsString;
-    float numberAsFloat;
+    byte  start = index;
+    float value = 0;
 
-    begin           =  readString.indexOf(target);
-    end             =  findEndOfNumber(readString,begin+1);
-    numberAsString  =  readString.substring(begin+1,end);
+    while (line[start] == ' '){
+        start++;
+    }
+    if (isDigit(line[start]) || line[start] == '-' || line[start] == '+' || line[start] == '.'){
+        readFloat(line, index, value);
+    }
 
-    numberAsFloat   =  numberAsString.toFloat();
+    return value;
+}
 
-    if (begin == -1){ //if the character was not found, return error
-        return defaultReturn;
+void  parseGcodeWords(const String& readString, gcodeWords_t& words){
+
+    /*Reads a line of gcode once from start to finish and records every letter on it and
+    the number which follows it, so the value of each word can be looked up without searching
+    the line again.  If a letter appears more than once the first one is used, the same as
+    extractGcodeValue().  A letter with no number after it is recorded with a value of 0.*/
+
+    const char* line = readString.c_str();
+    byte  index = 0;
+
+    words.present = 0;
+    while (line[index] != '\0'){
+        char letter = line[index];
+        index++;
+        if (letter < 'A' || letter > 'Z'){
+            continue;
+        }
+
+        unsigned long mask = 1UL << (letter - 'A');
+        if (bit_istrue(words.present, mask)){
+            continue;
+        }
+
+        bit_true(words.present, mask);
+        words.value[letter - 'A'] = readGcodeNumber(line, index);
     }
+}
 
-    return numberAsFloat;
+bool  gcodeWordPresent(const gcodeWords_t& words, const char& letter){
+    //Returns true if the letter was found by parseGcodeWords()
+    return bit_istrue(words.present, 1UL << (letter - 'A'));
+}
+
+float gcodeWordValue(const gcodeWords_t& words, const char& letter, const float& defaultReturn){
+    //Returns the value following the letter, or defaultReturn if the letter was not on the line
+    if (gcodeWordPresent(words, letter)){
+        return words.value[letter - 'A'];
+    }
+    return defaultReturn;
 }
 
 byte  executeBcodeLine(const String& gcodeLine){
@@ -124,7 +165,11 @@ byte  executeBcodeLine(const String& gcodeLine){
 
     //Handle B-codes
 
-    if(gcodeLine.substring(0, 3) == "B05"){
+    gcodeWords_t words;
+    parseGcodeWords(gcodeLine, words);
+    int bNumber = gcodeWordValue(words, 'B', -1);
+
+    if(bNumber == 5){
         Serial.print(F("Firmware Version "));
         Serial.println(VERSIONNUMBER);
         return STATUS_OK;
@@ -134,19 +179,19 @@ byte  executeBcodeLine(const String& gcodeLine){
       return STATUS_OLD_SETTINGS;
     }
 
-    if(gcodeLine.substring(0, 3) == "B01"){
+    if(bNumber == 1){
 
         Serial.println(F("Motor Calibration Not Needed"));
 
         return STATUS_OK;
     }
 
-    if(gcodeLine.substring(0, 3) == "B02"){
+    if(bNumber == 2){
         calibrateChainLengths(gcodeLine);
         return STATUS_OK;
     }
 
-    if(gcodeLine.substring(0, 3) == "B04"){
+    if(bNumber == 4){
         //set flag to ignore position error limit during the tests
         sys.state = (sys.state | STATE_POS_ERR_IGNORE);
         //Test each of the axis
@@ -170,10 +215,10 @@ byte  executeBcodeLine(const String& gcodeLine){
         return STATUS_OK;
     }
 
-    if(gcodeLine.substring(0, 3) == "B06"){
+    if(bNumber == 6){
         Serial.println(F("Setting Chain Lengths To: "));
-        float newL = extractGcodeValue(gcodeLine, 'L', 0);
-        float newR = extractGcodeValue(gcodeLine, 'R', 0);
+        float newL = gcodeWordValue(words, 'L', 0);
+        float newR = gcodeWordValue(words, 'R', 0);
 
         leftAxis.set(newL);
         rightAxis.set(newR);
@@ -188,7 +233,7 @@ byte  executeBcodeLine(const String& gcodeLine){
         return STATUS_OK;
     }
 
-    if(gcodeLine.substring(0, 3) == "B08"){
+    if(bNumber == 8){
         //Manually recalibrate chain lengths
         leftAxis.set(sysSettings.originalChainLength);
         rightAxis.set(sysSettings.originalChainLength);
@@ -200,18 +245,18 @@ byte  executeBcodeLine(const String& gcodeLine){
         Serial.print(rightAxis.read());
         Serial.println(F("mm"));
 
-        kinematics.forward(leftAxis.read(), rightAxis.read(), &sys.xPosition, &sys.yPosition, 0, 0);
+        kinematics.forward(leftAxis.read(), rightAxis.read(), &sys.xPosition, &sys.yPosition, sys.xPosition, sys.yPosition);
 
         Serial.println(F("Message: The machine chains have been manually re-calibrated."));
 
         return STATUS_OK;
     }
 
-    if(gcodeLine.substring(0, 3) == "B09"){
+    if(bNumber == 9){
         //Directly command each axis to move to a given distance
-        float lDist = extractGcodeValue(gcodeLine, 'L', 0);
-        float rDist = extractGcodeValue(gcodeLine, 'R', 0);
-        float speed = extractGcodeValue(gcodeLine, 'F', 800);
+        float lDist = gcodeWordValue(words, 'L', 0);
+        float rDist = gcodeWordValue(words, 'R', 0);
+        float speed = gcodeWordValue(words, 'F', 800);
 
         if(sys.useRelativeUnits){
             if(abs(lDist) > 0){
@@ -229,10 +274,10 @@ byte  executeBcodeLine(const String& gcodeLine){
         return STATUS_OK;
     }
 
-    if(gcodeLine.substring(0, 3) == "B10"){
+    if(bNumber == 10){
         //measure the left axis chain length
         Serial.print(F("[Measure: "));
-        if (gcodeLine.indexOf('L') != -1){
+        if (gcodeWordPresent(words, 'L')){
             Serial.print(leftAxis.read());
         }
         else{
@@ -242,10 +287,10 @@ byte  executeBcodeLine(const String& gcodeLine){
         return STATUS_OK;
     }
 
-    if(gcodeLine.substring(0, 3) == "B11"){
+    if(bNumber == 11){
         //run right motor in the given direction at the given speed for the given time
-        float  speed      = extractGcodeValue(gcodeLine, 'S', 100);
-        float  time       = extractGcodeValue(gcodeLine, 'T', 1);
+        float  speed      = gcodeWordValue(words, 'S', 100);
+        float  time       = gcodeWordValue(words, 'T', 1);
 
         double ms    = 1000*time;
         double begin = millis();
@@ -253,7 +298,7 @@ byte  executeBcodeLine(const String& gcodeLine){
         int i = 0;
         sys.state = (sys.state | STATE_POS_ERR_IGNORE);
         while (millis() - begin < ms){
-            if (gcodeLine.indexOf('L') != -1){
+            if (gcodeWordPresent(words, 'L')){
                 leftAxis.motorGearboxEncoder.motor.directWrite(speed);
             }
             else{
@@ -268,14 +313,14 @@ byte  executeBcodeLine(const String& gcodeLine){
         return STATUS_OK;
     }
 
-    if(gcodeLine.substring(0, 3) == "B13"){
+    if(bNumber == 13){
         //PID Testing of Velocity
-        float  left       = extractGcodeValue(gcodeLine, 'L', 0);
-        float  useZ       = extractGcodeValue(gcodeLine, 'Z', 0);
-        float  start      = extractGcodeValue(gcodeLine, 'S', 1);
-        float  stop       = extractGcodeValue(gcodeLine, 'F', 1);
-        float  steps      = extractGcodeValue(gcodeLine, 'I', 1);
-        float  version    = extractGcodeValue(gcodeLine, 'V', 1);
+        float  left       = gcodeWordValue(words, 'L', 0);
+        float  useZ       = gcodeWordValue(words, 'Z', 0);
+        float  start      = gcodeWordValue(words, 'S', 1);
+        float  stop       = gcodeWordValue(words, 'F', 1);
+        float  steps      = gcodeWordValue(words, 'I', 1);
+        float  version    = gcodeWordValue(words, 'V', 1);
 
         Axis* axis = &rightAxis;
         if (left > 0) axis = &leftAxis;
@@ -284,15 +329,15 @@ byte  executeBcodeLine(const String& gcodeLine){
         return STATUS_OK;
     }
 
-    if(gcodeLine.substring(0, 3) == "B14"){
+    if(bNumber == 14){
         //PID Testing of Position
-        float  left       = extractGcodeValue(gcodeLine, 'L', 0);
-        float  useZ       = extractGcodeValue(gcodeLine, 'Z', 0);
-        float  start      = extractGcodeValue(gcodeLine, 'S', 1);
-        float  stop       = extractGcodeValue(gcodeLine, 'F', 1);
-        float  steps      = extractGcodeValue(gcodeLine, 'I', 1);
-        float  stepTime   = extractGcodeValue(gcodeLine, 'T', 2000);
-        float  version    = extractGcodeValue(gcodeLine, 'V', 1);
+        float  left       = gcodeWordValue(words, 'L', 0);
+        float  useZ       = gcodeWordValue(words, 'Z', 0);
+        float  start      = gcodeWordValue(words, 'S', 1);
+        float  stop       = gcodeWordValue(words, 'F', 1);
+        float  steps      = gcodeWordValue(words, 'I', 1);
+        float  stepTime   = gcodeWordValue(words, 'T', 2000);
+        float  version    = gcodeWordValue(words, 'V', 1);
 
         Axis* axis = &rightAxis;
         if (left > 0) axis = &leftAxis;
@@ -301,12 +346,12 @@ byte  executeBcodeLine(const String& gcodeLine){
         return STATUS_OK;
     }
 
-    if(gcodeLine.substring(0, 3) == "B16"){
+    if(bNumber == 16){
         //Incrementally tests voltages to see what RPMs they produce
-        float  left       = extractGcodeValue(gcodeLine, 'L', 0);
-        float  useZ       = extractGcodeValue(gcodeLine, 'Z', 0);
-        float  start      = extractGcodeValue(gcodeLine, 'S', 1);
-        float  stop       = extractGcodeValue(gcodeLine, 'F', 1);
+        float  left       = gcodeWordValue(words, 'L', 0);
+        float  useZ       = gcodeWordValue(words, 'Z', 0);
+        float  start      = gcodeWordValue(words, 'S', 1);
+        float  stop       = gcodeWordValue(words, 'F', 1);
 
         Axis* axis = &rightAxis;
         if (left > 0) axis = &leftAxis;
@@ -315,7 +360,7 @@ byte  executeBcodeLine(const String& gcodeLine){
         return STATUS_OK;
     }
 
-    if(gcodeLine.substring(0, 3) == "B15"){
+    if(bNumber == 15){
         //The B15 command moves the chains to the length which will put the sled in the center of the sheet
 
         //Compute chain length for position 0,0
@@ -329,7 +374,7 @@ byte  executeBcodeLine(const String& gcodeLine){
         singleAxisMove(&rightAxis, chainLengthAtMiddle, 800);
 
         //Reload the position
-        kinematics.forward(leftAxis.read(), rightAxis.read(), &sys.xPosition, &sys.yPosition, 0, 0);
+        kinematics.forward(leftAxis.read(), rightAxis.read(), &sys.xPosition, &sys.yPosition, sys.xPosition, sys.yPosition);
 
         return STATUS_OK;
     }
@@ -403,6 +448,8 @@ void  executeMcodeLine(const String& gcodeLine){
 
     //Handle M-Codes
 
+    motionSynchronize();    // M-Codes act once the machine has finished the moves before them
+
     int mNumber = extractGcodeValue(gcodeLine,'M', -1);
 
     switch(mNumber){
@@ -557,6 +604,7 @@ byte  interpretCommandString(String& cmdString){
     if (cmdString.length() > 0) {
         if (cmdString[0] == '$') {
             // Maslow '$' system command
+            motionSynchronize();
             return(systemExecuteCmdstring(cmdString));
         }
         else if (cmdString[0] == 'B'){                   //If the command is a B command
@@ -564,6 +612,7 @@ byte  interpretCommandString(String& cmdString){
             Serial.print(F("iCS executing B code line: "));
             #endif
             Serial.println(cmdString);
+            motionSynchronize();
             return executeBcodeLine(cmdString);
         }
         else if (sys.state == STATE_OLD_SETTINGS){
@@ -619,13 +668,17 @@ byte  interpretCommandString(String& cmdString){
 void gcodeExecuteLoop(){
   byte status;
   if (incSerialBuffer.numberOfLines() > 0){
-      incSerialBuffer.prettyReadLine(readyCommandString);
+      PROFILESTART(PROFILE_GCODE);
+      char line[INCBUFFERLENGTH];   // holds any line, the buffer also has to fit its \n
+      incSerialBuffer.prettyReadLine(line, sizeof(line));
+      readyCommandString = line;
       sanitizeCommandString(readyCommandString);
       status = interpretCommandString(readyCommandString);
       readyCommandString = "";
 
       // Get next line of GCode
       if (!sys.stop){reportStatusMessage(status);}
+      PROFILEEND(PROFILE_GCODE);
   }
 }
 
@@ -638,25 +691,29 @@ void G1(const String& readString, int G0orG1){
     float ygoto;
     float zgoto;
 
-    float currentXPos = sys.xPosition;
-    float currentYPos = sys.yPosition;
+    float currentXPos;
+    float currentYPos;
+    float currentZPos;
+
+    plannerGetPosition(&currentXPos, &currentYPos, &currentZPos);   //where the last move in the planner ends
 
-    float currentZPos = zAxis.read();
+    gcodeWords_t words;
+    parseGcodeWords(readString, words);
 
-    xgoto      = sys.inchesToMMConversion*extractGcodeValue(readString, 'X', currentXPos/sys.inchesToMMConversion);
-    ygoto      = sys.inchesToMMConversion*extractGcodeValue(readString, 'Y', currentYPos/sys.inchesToMMConversion);
-    zgoto      = sys.inchesToMMConversion*extractGcodeValue(readString, 'Z', currentZPos/sys.inchesToMMConversion);
-    sys.feedrate   = sys.inchesToMMConversion*extractGcodeValue(readString, 'F', sys.feedrate/sys.inchesToMMConversion);
+    xgoto      = sys.inchesToMMConversion*gcodeWordValue(words, 'X', currentXPos/sys.inchesToMMConversion);
+    ygoto      = sys.inchesToMMConversion*gcodeWordValue(words, 'Y', currentYPos/sys.inchesToMMConversion);
+    zgoto      = sys.inchesToMMConversion*gcodeWordValue(words, 'Z', currentZPos/sys.inchesToMMConversion);
+    sys.feedrate   = sys.inchesToMMConversion*gcodeWordValue(words, 'F', sys.feedrate/sys.inchesToMMConversion);
 
     if (sys.useRelativeUnits){ //if we are using a relative coordinate system
 
-        if(readString.indexOf('X') >= 0){ //if there is an X command
+        if(gcodeWordPresent(words, 'X')){ //if there is an X command
             xgoto = currentXPos + xgoto;
         }
-        if(readString.indexOf('Y') >= 0){ //if y has moved
+        if(gcodeWordPresent(words, 'Y')){ //if y has moved
             ygoto = currentYPos + ygoto;
         }
-        if(readString.indexOf('Z') >= 0){ //if y has moved
+        if(gcodeWordPresent(words, 'Z')){ //if y has moved
             zgoto = currentZPos + zgoto;
         }
     }
@@ -679,9 +736,11 @@ void G1(const String& readString, int G0orG1){
                 Serial.println(F(" mm"));
             }
 
+            motionSynchronize(); //Finish the moves before this one
             pause(); //Wait until the z-axis is adjusted
 
             zAxis.set(zgoto);
+            plannerSetZPosition(zgoto);
 
             maslowDelay(1000);
         }
@@ -706,17 +765,22 @@ void G2(const String& readString, int G2orG3){
 
     */
 
+    motionSynchronize(); //arcs are not run through the planner yet
+
+    float X1; //does this work if units are inches? (It seems to)
+    float Y1;
+    float Z1;
+    plannerGetPosition(&X1, &Y1, &Z1);
 
-    float X1 = sys.xPosition; //does this work if units are inches? (It seems to)
-    float Y1 = sys.yPosition;
-    float Z1 = zAxis.read();  // I don't know why we treat the zaxis differently
+    gcodeWords_t words;
+    parseGcodeWords(readString, words);
 
-    float X2      = sys.inchesToMMConversion*extractGcodeValue(readString, 'X', X1/sys.inchesToMMConversion);
-    float Y2      = sys.inchesToMMConversion*extractGcodeValue(readString, 'Y', Y1/sys.inchesToMMConversion);
-    float Z2      = sys.inchesToMMConversion*extractGcodeValue(readString, 'Z', Z1/sys.inchesToMMConversion);
-    float I       = sys.inchesToMMConversion*extractGcodeValue(readString, 'I', 0.0);
-    float J       = sys.inchesToMMConversion*extractGcodeValue(readString, 'J', 0.0);
-    sys.feedrate      = sys.inchesToMMConversion*extractGcodeValue(readString, 'F', sys.feedrate/sys.inchesToMMConversion);
+    float X2      = sys.inchesToMMConversion*gcodeWordValue(words, 'X', X1/sys.inchesToMMConversion);
+    float Y2      = sys.inchesToMMConversion*gcodeWordValue(words, 'Y', Y1/sys.inchesToMMConversion);
+    float Z2      = sys.inchesToMMConversion*gcodeWordValue(words, 'Z', Z1/sys.inchesToMMConversion);
+    float I       = sys.inchesToMMConversion*gcodeWordValue(words, 'I', 0.0);
+    float J       = sys.inchesToMMConversion*gcodeWordValue(words, 'J', 0.0);
+    sys.feedrate      = sys.inchesToMMConversion*gcodeWordValue(words, 'F', sys.feedrate/sys.inchesToMMConversion);
 
     float centerX = X1 + I;
     float centerY = Y1 + J;
@@ -739,8 +803,11 @@ void  G4(const String& readString){
       Because maslowDelay() operates in milliseconds, round to the nearest millisecond.
       Negative values are treated as positive (not a time machine).
     */
-    float dwellMS = abs(extractGcodeValue(readString, 'P', 0));
-    float dwellS  = abs(extractGcodeValue(readString, 'S', 0));
+    motionSynchronize();
+    gcodeWords_t words;
+    parseGcodeWords(readString, words);
+    float dwellMS = abs(gcodeWordValue(words, 'P', 0));
+    float dwellS  = abs(gcodeWordValue(words, 'S', 0));
 
     if (dwellMS == 0) {
       /*
@@ -762,35 +829,44 @@ void  G4(const String& readString){
 
 void  G10(const String& readString){
     /*The G10() function handles the G10 gcode which re-zeros one or all of the machine's axes.*/
-    float currentZPos = zAxis.read();
-    float zgoto      = sys.inchesToMMConversion*extractGcodeValue(readString, 'Z', currentZPos/sys.inchesToMMConversion);
+    motionSynchronize();
+    gcodeWords_t words;
+    parseGcodeWords(readString, words);
+    float currentXPos, currentYPos, currentZPos;
+    plannerGetPosition(&currentXPos, &currentYPos, &currentZPos);
+    float zgoto      = sys.inchesToMMConversion*gcodeWordValue(words, 'Z', currentZPos/sys.inchesToMMConversion);
 
     zAxis.set(zgoto);
     zAxis.endMove(zgoto);
     zAxis.attach();
+    plannerSetZPosition(zgoto);
 }
 
 void  G38(const String& readString) {
+  motionSynchronize();
   //if the zaxis is attached
   if (sysSettings.zAxisAttached) {
     /*
        The G38() function handles the G38 gcode which zeros the machine's z axis.
        Currently ignores X and Y options
     */
-    if (readString.substring(3, 5) == ".2") {
+    gcodeWords_t words;
+    parseGcodeWords(readString, words);
+    if (fabs(gcodeWordValue(words, 'G', 0) - 38.2) < 0.001) {
       Serial.println(F("probing for z axis zero"));
       float zgoto;
 
 
-      float currentZPos = zAxis.read();
+      float currentXPos, currentYPos, currentZPos;
+      plannerGetPosition(&currentXPos, &currentYPos, &currentZPos);
       int   zDirection = sysSettings.zEncoderSteps<0 ? -1 : 1;
 
-      zgoto = zDirection * sys.inchesToMMConversion * extractGcodeValue(readString, 'Z', currentZPos / sys.inchesToMMConversion);
-      sys.feedrate   = sys.inchesToMMConversion * extractGcodeValue(readString, 'F', sys.feedrate / sys.inchesToMMConversion);
+      zgoto = zDirection * sys.inchesToMMConversion * gcodeWordValue(words, 'Z', currentZPos / sys.inchesToMMConversion);
+      sys.feedrate   = sys.inchesToMMConversion * gcodeWordValue(words, 'F', sys.feedrate / sys.inchesToMMConversion);
       sys.feedrate = constrain(sys.feedrate, 1, sysSettings.maxZRPM * abs(zAxis.getPitch()));
 
       if (sys.useRelativeUnits) { //if we are using a relative coordinate system
-        if (readString.indexOf('Z') >= 0) { //if z has moved
+        if (gcodeWordPresent(words, 'Z')) { //if z has moved
           zgoto = currentZPos + zgoto;
         }
       }
@@ -819,46 +895,46 @@ void  G38(const String& readString) {
         */
 
         Axis* axis = &zAxis;
-        float startingPos          = axis->read();
+        float startingPos          = currentZPos;
         float endPos               = zgoto;
         float moveDist             = endPos - currentZPos; //total distance to move
 
-        float direction            = moveDist / abs(moveDist); //determine the direction of the move
-
-        float stepSizeMM           = 0.01;                    //step size in mm
-
-        //the argument to abs should only be a variable -- splitting calc into 2 lines
-        long finalNumberOfSteps    = moveDist / stepSizeMM;    //number of steps taken in move
-        finalNumberOfSteps = abs(finalNumberOfSteps);
+        float direction            = moveDist < 0 ? -1 : 1; //determine the direction of the move
+        float distance             = fabs(moveDist);
 
-        long numberOfStepsTaken    = 0;
-        float whereAxisShouldBeAtThisStep = startingPos;
+        float nominalSpeed         = 0.01 * 1000000.0 / LOOPINTERVAL; //0.01mm a step, in mm/s
+        float speed                = 0;
+        float distanceTraveled     = 0;
 
         axis->attach();
         //  zAxis->attach();
-
-        while (numberOfStepsTaken < finalNumberOfSteps) {
-          if (!movementUpdated){
-              //find the target point for this step
-              whereAxisShouldBeAtThisStep += stepSizeMM * direction;
-
-              //write to each axis
-              axis->write(whereAxisShouldBeAtThisStep);
-              movementUpdate();
-
-              // Run realtime commands
-              execSystemRealtime();
-              if (sys.stop){return;}
-
-              //increment the number of steps taken
-              numberOfStepsTaken++;
+        inMovementLoop = true;
+
+        //keep checking the probe until the last setpoint has been reached
+        while (distanceTraveled < distance || !motionSetpointQueueEmpty()) {
+          if (distanceTraveled < distance && !motionSetpointQueueFull()){
+              //find the target point for this step, speeding up and slowing down at zAcceleration
+              speed             = motionProfileSpeed(speed, distance - distanceTraveled, nominalSpeed, sysSettings.zAcceleration);
+              distanceTraveled += speed * LOOPINTERVAL / 1000000.0;
+              float whereAxisShouldBeAtThisStep = (distanceTraveled < distance) ? startingPos + direction * distanceTraveled : endPos;
+
+              //queue for the axis
+              motionQueueSetpoint(0, 0, whereAxisShouldBeAtThisStep, SETPOINT_Z);
+              inMovementLoop = (distanceTraveled < distance);
           }
 
+          // Run realtime commands
+          execSystemRealtime();
+          if (sys.stop){return;}
+
           //check for Probe touchdown
           if (checkForProbeTouch(ProbePin)) {
+            motionClearSetpoints();
+            inMovementLoop = false;
             zAxis.set(0);
             zAxis.endMove(0);
             zAxis.attach();
+            plannerSetZPosition(0);
             Serial.println(F("z axis zeroed"));
             return;
           }
@@ -869,7 +945,9 @@ void  G38(const String& readString) {
             - print error
             - STOP execution
         */
+        motionClearSetpoints();
         axis->endMove(endPos);
+        plannerSetZPosition(endPos);
         Serial.println(F("error: probe did not connect\nprogram stopped\nz axis not set\n"));
         sys.stop = true;
       } // end if zgoto != currentZPos / sys.inchesToMMConversion
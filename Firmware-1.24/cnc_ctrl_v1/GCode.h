@@ -22,6 +22,12 @@ Copyright 2014-2017 Bar Smith*/
 #define LINE_FLAG_COMMENT_PARENTHESES bit(0)
 #define LINE_FLAG_COMMENT_SEMICOLON bit(1)
 
+// The words (letter and number pairs) found on a line of gcode by parseGcodeWords()
+typedef struct {
+  unsigned long present;      // Bit n is set if letter 'A' + n is on the line
+  float value[26];            // The number following each letter which is present
+} gcodeWords_t;
+
 extern String readyCommandString; //next command queued up and ready to send
 extern String gcodeLine; //The next individual line of gcode (for example G91 G01 X19 would be run as two lines)
 
@@ -29,8 +35,11 @@ void initGCode();
 void gcodeExecuteLoop();
 void readSerialCommands();
 String gcodeBufferReadline();
-int   findEndOfNumber(const String&, const int&);
 float extractGcodeValue(const String&, char, const float&);
+float readGcodeNumber(const char*, byte&);
+void  parseGcodeWords(const String&, gcodeWords_t&);
+bool  gcodeWordPresent(const gcodeWords_t&, const char&);
+float gcodeWordValue(const gcodeWords_t&, const char&, const float&);
 byte  executeBcodeLine(const String&);
 void  executeGcodeLine(const String&);
 void  executeMcodeLine(const String&);
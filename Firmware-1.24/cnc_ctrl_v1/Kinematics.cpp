@@ -28,6 +28,11 @@ Kinematics::Kinematics(){
 }
 
 void Kinematics::init(){
+    /*
+    Works out the machine geometry and finds the sled from the chain lengths, starting
+    from the last known position.  That is the middle of the sheet at power up, when
+    sys is still zeroed, and forward() puts it back there if it fails.
+    */
     recomputeGeometry();
     if (sys.state != STATE_OLD_SETTINGS){
       forward(leftAxis.read(), rightAxis.read(), &sys.xPosition, &sys.yPosition, sys.xPosition, sys.yPosition);
@@ -59,10 +64,57 @@ void Kinematics::recomputeGeometry(){
     _xCordOfMotor = sysSettings.distBetweenMotors/2;
     _yCordOfMotor = halfHeight + sysSettings.motorOffsetY;
 
+    #if KINEMATICSCACHE > 0
+      float geometry[KINEMATICSCACHEGEOMETRY];
+      _cacheGeometry(geometry);
+      if (memcmp(geometry, _cachedGeometry, sizeof(geometry)) != 0){
+          //the old cache no longer matches the machine, updateCache() will fill in a new one
+          memcpy(_cachedGeometry, geometry, sizeof(geometry));
+          _cacheValid     = false;
+          _cacheBuildStep = 0;
+          cacheError      = -1;
+          //only the quadrilateral kinematics are slow enough for interpolating to be quicker
+          if (sysSettings.kinematicsType == 1 && sysSettings.machineWidth > 0 && sysSettings.machineHeight > 0){
+              _cacheInvStepX = (KINEMATICSCACHECOLS - 1) / sysSettings.machineWidth;
+              _cacheInvStepY = (KINEMATICSCACHEROWS - 1) / sysSettings.machineHeight;
+
+              //entries are stored relative to the center of the sheet so they fit in an int
+              float aChain, bChain, aStraight, bStraight;
+              _exactInverse(0, 0, &aChain, &bChain);
+              _straightChainLengths(0, 0, &aStraight, &bStraight);
+              _cacheOffsetA    = aChain - aStraight;
+              _cacheOffsetB    = bChain - bStraight;
+              _cacheWorstError = 0;
+              _cacheBuildStep  = 1;
+          }
+      }
+    #endif
 }
 
 void  Kinematics::inverse(float xTarget,float yTarget, float* aChainLength, float* bChainLength){
     /*
+
+    Returns the chain lengths for a target point, either by interpolating the chain length
+    cache or by solving the kinematics exactly
+
+    */
+
+    PROFILESTART(PROFILE_INVERSE);
+    #if KINEMATICSCACHE > 0
+      if (_cacheValid){
+          _cachedInverse(xTarget, yTarget, aChainLength, bChainLength);
+      }
+      else{
+          _exactInverse(xTarget, yTarget, aChainLength, bChainLength);
+      }
+    #else
+      _exactInverse(xTarget, yTarget, aChainLength, bChainLength);
+    #endif
+    PROFILEEND(PROFILE_INVERSE);
+}
+
+void  Kinematics::_exactInverse(float xTarget,float yTarget, float* aChainLength, float* bChainLength){
+    /*
     
     This function works as a switch to call either the quadrilateralInverse kinematic function 
     or the triangularInverse kinematic function
@@ -201,39 +253,59 @@ void  Kinematics::triangularInverse(float xTarget,float yTarget, float* aChainLe
     //Confirm that the coordinates are on the wood
     _verifyValidTarget(&xTarget, &yTarget);
 
-    //Set up variables
-    float Chain1Angle = 0;
-    float Chain2Angle = 0;
-    float Chain1AroundSprocket = 0;
-    float Chain2AroundSprocket = 0;
-
     //Calculate motor axes length to the bit
-    float Motor1Distance = sqrt(pow((-1*_xCordOfMotor - xTarget),2)+pow((_yCordOfMotor - yTarget),2));
-    float Motor2Distance = sqrt(pow((_xCordOfMotor - xTarget),2)+pow((_yCordOfMotor - yTarget),2));
+    float xDistance1 = _xCordOfMotor + xTarget;      //horizontal distance from each motor to the bit
+    float xDistance2 = _xCordOfMotor - xTarget;
+    float yDistance  = _yCordOfMotor - yTarget;      //vertical distance from the motors to the bit
+    float Motor1DistanceSq = xDistance1*xDistance1 + yDistance*yDistance;
+    float Motor2DistanceSq = xDistance2*xDistance2 + yDistance*yDistance;
 
-    //Calculate the chain angles from horizontal, based on if the chain connects to the sled from the top or bottom of the sprocket
+    //Calculate the straight chain length from the sprocket to the bit
+    float RSq = R*R;
+    float Chain1Straight = sqrt(Motor1DistanceSq - RSq);
+    float Chain2Straight = sqrt(Motor2DistanceSq - RSq);
+
+    //Calculate the chain angles from horizontal, based on if the chain connects to the sled from the top or bottom of the sprocket.
+    //The angle is the angle of the line from the motor to the bit plus or minus the angle between that line and the chain, which
+    //is the sum of two asin() terms.  Adding the angles as vectors instead gives the sine and cosine of the chain angle directly,
+    //each scaled by the motor distance squared, so only one atan2() is needed for each chain.
+    float Chain1AngleX;
+    float Chain1AngleY;
+    float Chain2AngleX;
+    float Chain2AngleY;
+    float Chain1AroundSprocket;
+    float Chain2AroundSprocket;
     if(sysSettings.chainOverSprocket == 1){
-        Chain1Angle = asin((_yCordOfMotor - yTarget)/Motor1Distance) + asin(R/Motor1Distance);
-        Chain2Angle = asin((_yCordOfMotor - yTarget)/Motor2Distance) + asin(R/Motor2Distance);
+        Chain1AngleX = abs(xDistance1) * Chain1Straight - yDistance * R;
+        Chain1AngleY = yDistance * Chain1Straight + abs(xDistance1) * R;
+        Chain2AngleX = abs(xDistance2) * Chain2Straight - yDistance * R;
+        Chain2AngleY = yDistance * Chain2Straight + abs(xDistance2) * R;
 
-        Chain1AroundSprocket = R * Chain1Angle;
-        Chain2AroundSprocket = R * Chain2Angle;
+        Chain1AroundSprocket = R * _atan2(Chain1AngleY, Chain1AngleX);
+        Chain2AroundSprocket = R * _atan2(Chain2AngleY, Chain2AngleX);
     }
     else{
-        Chain1Angle = asin((_yCordOfMotor - yTarget)/Motor1Distance) - asin(R/Motor1Distance);
-        Chain2Angle = asin((_yCordOfMotor - yTarget)/Motor2Distance) - asin(R/Motor2Distance);
+        Chain1AngleX = abs(xDistance1) * Chain1Straight + yDistance * R;
+        Chain1AngleY = yDistance * Chain1Straight - abs(xDistance1) * R;
+        Chain2AngleX = abs(xDistance2) * Chain2Straight + yDistance * R;
+        Chain2AngleY = yDistance * Chain2Straight - abs(xDistance2) * R;
 
-        Chain1AroundSprocket = R * (3.14159 - Chain1Angle);
-        Chain2AroundSprocket = R * (3.14159 - Chain2Angle);
+        Chain1AroundSprocket = R * (3.14159 - _atan2(Chain1AngleY, Chain1AngleX));
+        Chain2AroundSprocket = R * (3.14159 - _atan2(Chain2AngleY, Chain2AngleX));
     }
 
-    //Calculate the straight chain length from the sprocket to the bit
-    float Chain1Straight = sqrt(pow(Motor1Distance,2)-pow(R,2));
-    float Chain2Straight = sqrt(pow(Motor2Distance,2)-pow(R,2));
-
     //Correct the straight chain lengths to account for chain sag
-    Chain1Straight *= (1 + ((sysSettings.chainSagCorrection / 1000000000000) * pow(cos(Chain1Angle),2) * pow(Chain1Straight,2) * pow((tan(Chain2Angle) * cos(Chain1Angle)) + sin(Chain1Angle),2)));
-    Chain2Straight *= (1 + ((sysSettings.chainSagCorrection / 1000000000000) * pow(cos(Chain2Angle),2) * pow(Chain2Straight,2) * pow((tan(Chain1Angle) * cos(Chain2Angle)) + sin(Chain2Angle),2)));
+    if (sysSettings.chainSagCorrection != 0){
+        float Cos1 = Chain1AngleX / Motor1DistanceSq;
+        float Sin1 = Chain1AngleY / Motor1DistanceSq;
+        float Cos2 = Chain2AngleX / Motor2DistanceSq;
+        float Sin2 = Chain2AngleY / Motor2DistanceSq;
+        float Sag1 = (Sin2 / Cos2) * Cos1 + Sin1;    //tan(Chain2Angle) * cos(Chain1Angle) + sin(Chain1Angle)
+        float Sag2 = (Sin1 / Cos1) * Cos2 + Sin2;
+        float sagScale = sysSettings.chainSagCorrection / 1000000000000;
+        Chain1Straight *= (1 + sagScale * Cos1*Cos1 * Chain1Straight*Chain1Straight * Sag1*Sag1);
+        Chain2Straight *= (1 + sagScale * Cos2*Cos2 * Chain2Straight*Chain2Straight * Sag2*Sag2);
+    }
 
     //Calculate total chain lengths accounting for sprocket geometry and chain sag
     float Chain1 = Chain1AroundSprocket + Chain1Straight * (1.0f + sysSettings.leftChainTolerance / 100.0f);
@@ -248,30 +320,37 @@ void  Kinematics::triangularInverse(float xTarget,float yTarget, float* aChainLe
 }
 
 void  Kinematics::forward(const float& chainALength, const float& chainBLength, float* xPos, float* yPos, float xGuess, float yGuess){
+    /*
+    
+    Finds the position of the sled from the chain lengths by Newton's method.  Each iteration
+    solves the inverse kinematics at the guess and a small step away in x and in y, which
+    gives the chain length errors and how they change with the position, and moves the guess
+    to where the errors would be zero if the chain lengths changed linearly.  From a guess
+    anywhere on the sheet this usually takes three or four iterations.
+    
+    */
   
     Serial.println(F("[Forward Calculating Position]"));
     
 
     float guessLengthA;
     float guessLengthB;
+    float aChainError;
+    float bChainError;
 
-    int guessCount = 0;
+    forwardIterations = 0;
 
     while(1){
 
+        //the inverse kinematics stop at the edge of the sheet, so the guess has to stay on it
+        _verifyValidTarget(&xGuess, &yGuess);
 
         //check our guess
-        inverse(xGuess, yGuess, &guessLengthA, &guessLengthB);
-
-        float aChainError = chainALength - guessLengthA;
-        float bChainError = chainBLength - guessLengthB;
+        _exactInverse(xGuess, yGuess, &guessLengthA, &guessLengthB);
 
-
-        //adjust the guess based on the result
-        xGuess = xGuess + .1*aChainError - .1*bChainError;
-        yGuess = yGuess - .1*aChainError - .1*bChainError;
-        
-        guessCount++;
+        aChainError = chainALength - guessLengthA;
+        bChainError = chainBLength - guessLengthB;
+        forwardError = max(abs(aChainError), abs(bChainError));
 
         #if defined (KINEMATICSDBG) && KINEMATICSDBG > 0 
           Serial.print(F("[PEk:"));
@@ -283,32 +362,214 @@ void  Kinematics::forward(const float& chainALength, const float& chainBLength,
           Serial.println(F("]"));
         #endif
 
-        execSystemRealtime();
-        // No need for sys.stop check here
-
         //if we've converged on the point...or it's time to give up, exit the loop
-        if((abs(aChainError) < .1 && abs(bChainError) < .1) or guessCount > KINEMATICSMAXGUESS or guessLengthA > sysSettings.chainLength  or guessLengthB > sysSettings.chainLength){
-            if((guessCount > KINEMATICSMAXGUESS) or guessLengthA > sysSettings.chainLength or guessLengthB > sysSettings.chainLength){
-                Serial.print(F("Message: Unable to find valid machine position for chain lengths "));
-                Serial.print(chainALength);
-                Serial.print(", ");
-                Serial.print(chainBLength);
-                Serial.println(F(" . Please set the chains to a known length (Actions -> Set Chain Lengths)"));
-                *xPos = 0;
-                *yPos = 0;
-            }
-            else{
-                Serial.println("position loaded at:");
-                Serial.println(xGuess);
-                Serial.println(yGuess);
-                *xPos = xGuess;
-                *yPos = yGuess;
-            }
+        if(forwardError < KINEMATICSFORWARDERROR or forwardIterations >= KINEMATICSMAXGUESS){
+            break;
+        }
+        forwardIterations++;
+
+        //find how the chain lengths change with the position, stepping towards the middle of
+        //the sheet so that the step is never cut off at the edge
+        float xStep = (xGuess > 0) ? -KINEMATICSFORWARDSTEP : KINEMATICSFORWARDSTEP;
+        float yStep = (yGuess > 0) ? -KINEMATICSFORWARDSTEP : KINEMATICSFORWARDSTEP;
+        float xStepLengthA, xStepLengthB, yStepLengthA, yStepLengthB;
+        _exactInverse(xGuess + xStep, yGuess, &xStepLengthA, &xStepLengthB);
+        _exactInverse(xGuess, yGuess + yStep, &yStepLengthA, &yStepLengthB);
+
+        float dAdX = (xStepLengthA - guessLengthA)/xStep;
+        float dAdY = (yStepLengthA - guessLengthA)/yStep;
+        float dBdX = (xStepLengthB - guessLengthB)/xStep;
+        float dBdY = (yStepLengthB - guessLengthB)/yStep;
+        float determinant = dAdX*dBdY - dAdY*dBdX;
+        if (abs(determinant) < 1e-6){
+            forwardIterations = KINEMATICSMAXGUESS;
             break;
         }
+
+        //adjust the guess based on the result
+        xGuess = xGuess + ( dBdY*aChainError - dAdY*bChainError)/determinant;
+        yGuess = yGuess + (-dBdX*aChainError + dAdX*bChainError)/determinant;
+    }
+
+    if(forwardError >= KINEMATICSFORWARDERROR or guessLengthA > sysSettings.chainLength or guessLengthB > sysSettings.chainLength){
+        Serial.print(F("Message: Unable to find valid machine position for chain lengths "));
+        Serial.print(chainALength);
+        Serial.print(", ");
+        Serial.print(chainBLength);
+        Serial.println(F(" . Please set the chains to a known length (Actions -> Set Chain Lengths)"));
+        *xPos = 0;
+        *yPos = 0;
+    }
+    else{
+        Serial.println("position loaded at:");
+        Serial.println(xGuess);
+        Serial.println(yGuess);
+        *xPos = xGuess;
+        *yPos = yGuess;
     }
+    Serial.print(F("after "));
+    Serial.print(forwardIterations);
+    Serial.print(F(" iterations with a chain length error of "));
+    Serial.print(forwardError, 4);
+    Serial.println(F("mm"));
+}
+
+#if KINEMATICSCACHE > 0
+void  Kinematics::_straightChainLengths(const float& xTarget, const float& yTarget, float* aLength, float* bLength){
+    /*
+    Straight line distance from each motor to the target point.  This accounts for almost all
+    of the change in chain length across the sheet so the cache only needs to store what is
+    left over, which is small and varies smoothly enough to interpolate accurately.
+    */
+    float dY  = _yCordOfMotor - yTarget;
+    float dXA = _xCordOfMotor + xTarget;
+    float dXB = _xCordOfMotor - xTarget;
+    *aLength = sqrt(dXA*dXA + dY*dY);
+    *bLength = sqrt(dXB*dXB + dY*dY);
 }
 
+float Kinematics::_cacheColumnX(const int& col){
+    /*
+    x of a column of the cache grid.  The chain lengths bend most towards the sides of the
+    sheet, so the columns are placed closer together there, KINEMATICSCACHESIDES sets by how much
+    */
+    float s = col * (2.0 / (KINEMATICSCACHECOLS - 1)) - 1;
+    return halfWidth * s * (1 - KINEMATICSCACHESIDES * s * s) / (1 - KINEMATICSCACHESIDES);
+}
+
+float Kinematics::_cacheRowY(const int& row){
+    /*
+    y of a row of the cache grid.  The chain lengths bend most near the motors, so the rows
+    are placed closer together towards the top of the sheet, KINEMATICSCACHETOP sets by how much
+    */
+    float u = row * (1.0 / (KINEMATICSCACHEROWS - 1));
+    return halfHeight * (2 * u * (1 + KINEMATICSCACHETOP * (1 - u)) - 1);
+}
+
+void  Kinematics::_cacheGeometry(float* geometry){
+    /*
+    Collects every setting which changes the chain lengths so recomputeGeometry() can tell if
+    the cache needs to be rebuilt.  KINEMATICSCACHEGEOMETRY must match the number of entries.
+    */
+    geometry[0]  = sysSettings.machineWidth;
+    geometry[1]  = sysSettings.machineHeight;
+    geometry[2]  = sysSettings.distBetweenMotors;
+    geometry[3]  = sysSettings.motorOffsetY;
+    geometry[4]  = sysSettings.sledWidth;
+    geometry[5]  = sysSettings.sledHeight;
+    geometry[6]  = sysSettings.sledCG;
+    geometry[7]  = sysSettings.kinematicsType;
+    geometry[8]  = sysSettings.rotationDiskRadius;
+    geometry[9]  = sysSettings.chainSagCorrection;
+    geometry[10] = sysSettings.chainOverSprocket;
+    geometry[11] = sysSettings.leftChainTolerance;
+    geometry[12] = sysSettings.rightChainTolerance;
+    geometry[13] = R;
+}
+
+void  Kinematics::updateCache(){
+    /*
+    Fills in one point of the chain length cache each time it is called so that rebuilding
+    the cache never holds up the serial connection for long.  Once every grid point is
+    filled in, the interpolated chain lengths are compared against the exact solution at
+    the center of every cell, where bilinear interpolation is least accurate.  The cache is
+    only used if the worst error found is within KINEMATICSCACHEMAXERROR, otherwise inverse()
+    keeps solving every point exactly.
+    */
+
+    if (_cacheBuildStep == 0){
+        return;
+    }
+
+    float aChain, bChain;
+    unsigned int point = _cacheBuildStep - 1;
+    if (point < KINEMATICSCACHEROWS * KINEMATICSCACHECOLS){
+        byte  row    = point / KINEMATICSCACHECOLS;
+        byte  col    = point % KINEMATICSCACHECOLS;
+        float xPoint = _cacheColumnX(col);
+        float yPoint = _cacheRowY(row);
+        float aStraight, bStraight;
+        _exactInverse(xPoint, yPoint, &aChain, &bChain);
+        _straightChainLengths(xPoint, yPoint, &aStraight, &bStraight);
+        //an entry which doesn't fit is clipped and shows up as a large error when checked below
+        _cacheA[row][col] = constrain(lround((aChain - aStraight - _cacheOffsetA) * KINEMATICSCACHESCALE), -32767L, 32767L);
+        _cacheB[row][col] = constrain(lround((bChain - bStraight - _cacheOffsetB) * KINEMATICSCACHESCALE), -32767L, 32767L);
+    }
+    else{
+        point -= KINEMATICSCACHEROWS * KINEMATICSCACHECOLS;
+        byte  row    = point / (KINEMATICSCACHECOLS - 1);
+        byte  col    = point % (KINEMATICSCACHECOLS - 1);
+        float xPoint = 0.5 * (_cacheColumnX(col) + _cacheColumnX(col + 1));
+        float yPoint = 0.5 * (_cacheRowY(row) + _cacheRowY(row + 1));
+        float aCached, bCached;
+        _exactInverse(xPoint, yPoint, &aChain, &bChain);
+        _cachedInverse(xPoint, yPoint, &aCached, &bCached);
+        _cacheWorstError = max(_cacheWorstError, max(fabs(aChain - aCached), fabs(bChain - bCached)));
+    }
+
+    _cacheBuildStep++;
+    if (_cacheBuildStep > KINEMATICSCACHEROWS * KINEMATICSCACHECOLS + (KINEMATICSCACHEROWS - 1) * (KINEMATICSCACHECOLS - 1)){
+        _cacheBuildStep = 0;
+        cacheError      = _cacheWorstError;
+        _cacheValid     = (cacheError <= KINEMATICSCACHEMAXERROR);
+        Serial.print(F("Kinematics cache max error: "));
+        Serial.print(cacheError, 4);
+        Serial.print(F(" mm"));
+        if (!_cacheValid){
+            Serial.print(F(", not used"));
+        }
+        Serial.println();
+    }
+}
+
+void  Kinematics::_cachedInverse(float xTarget,float yTarget, float* aChainLength, float* bChainLength){
+    /*
+    Returns the chain lengths for a target point by interpolating the residuals stored in the
+    cache and adding them back onto the straight line distance to each motor
+    */
+
+    _verifyValidTarget(&xTarget, &yTarget);
+
+    //the grid is not evenly spaced, so start from the cell an even grid would have and
+    //step across to the one the target is in, which is never more than a few cells away
+    byte  col = constrain((int)((xTarget + halfWidth) * _cacheInvStepX), 0, KINEMATICSCACHECOLS - 2);
+    byte  row = constrain((int)((yTarget + halfHeight) * _cacheInvStepY), 0, KINEMATICSCACHEROWS - 2);
+    float left   = _cacheColumnX(col);
+    float right  = _cacheColumnX(col + 1);
+    while (xTarget < left && col > 0){
+        right = left;
+        left  = _cacheColumnX(--col);
+    }
+    while (xTarget > right && col < KINEMATICSCACHECOLS - 2){
+        left  = right;
+        right = _cacheColumnX(++col + 1);
+    }
+    float bottom = _cacheRowY(row);
+    float top    = _cacheRowY(row + 1);
+    while (yTarget < bottom && row > 0){
+        top    = bottom;
+        bottom = _cacheRowY(--row);
+    }
+    while (yTarget > top && row < KINEMATICSCACHEROWS - 2){
+        bottom = top;
+        top    = _cacheRowY(++row + 1);
+    }
+    float tx  = (xTarget - left)   / (right - left);
+    float ty  = (yTarget - bottom) / (top - bottom);
+
+    float aBottom = _cacheA[row][col]   + tx * (_cacheA[row][col+1]   - _cacheA[row][col]);
+    float aTop    = _cacheA[row+1][col] + tx * (_cacheA[row+1][col+1] - _cacheA[row+1][col]);
+    float bBottom = _cacheB[row][col]   + tx * (_cacheB[row][col+1]   - _cacheB[row][col]);
+    float bTop    = _cacheB[row+1][col] + tx * (_cacheB[row+1][col+1] - _cacheB[row+1][col]);
+
+    float aStraight, bStraight;
+    _straightChainLengths(xTarget, yTarget, &aStraight, &bStraight);
+
+    *aChainLength = aStraight + _cacheOffsetA + (aBottom + ty * (aTop - aBottom)) * (1.0 / KINEMATICSCACHESCALE);
+    *bChainLength = bStraight + _cacheOffsetB + (bBottom + ty * (bTop - bBottom)) * (1.0 / KINEMATICSCACHESCALE);
+}
+#endif
+
 void  Kinematics::_MatSolv(){
     float Sum;
     int NN;
@@ -418,6 +679,31 @@ void Kinematics::_MyTrig(){
 
 }
 
+float Kinematics::_atan2(const float& y, const float& x){
+    /*
+    atan2() for the triangular kinematics.  If KINEMATICSFASTTRIG is set this uses a polynomial
+    fit of atan() on 0 to 1 instead of the library function, the other octants are found by
+    symmetry.  The error is less than 1.2e-5 radians, which is 0.00012mm of chain on the sprocket.
+    */
+    #if KINEMATICSFASTTRIG > 0
+        float absX = abs(x);
+        float absY = abs(y);
+        bool  steep = absY > absX;
+        float z = steep ? absX/absY : absY/absX;
+        float zSq = z*z;
+        float angle = z*(0.9998660 + zSq*(-0.3302995 + zSq*(0.1801410 + zSq*(-0.0851330 + zSq*0.0208351))));
+        if (steep){
+            angle = 1.5707963 - angle;
+        }
+        if (x < 0){
+            angle = 3.1415927 - angle;
+        }
+        return (y < 0) ? -angle : angle;
+    #else
+        return atan2(y, x);
+    #endif
+}
+
 float Kinematics::_YOffsetEqn(const float& YPlus, const float& Denominator, const float& Psi){
     float Temp;
     Temp = ((sqrt(YPlus * YPlus - R * R)/R) - (y + YPlus - h * sin(Psi))/Denominator);
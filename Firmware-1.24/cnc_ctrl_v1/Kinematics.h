@@ -24,7 +24,18 @@
     #define DELTAY 0.01
     #define KINEMATICSMAXERROR 0.001
     #define KINEMATICSMAXINVERSE 10
-    #define KINEMATICSMAXGUESS 200
+    #define KINEMATICSMAXGUESS 20             //iterations of forward() before giving up
+    #define KINEMATICSFORWARDERROR 0.01       //mm, how close forward() must match the chain lengths
+    #define KINEMATICSFORWARDSTEP 1.0         //mm, step used by forward() to find how the chain lengths change
+
+    //Chain length cache, only used if KINEMATICSCACHE is set in Config.h
+    #define KINEMATICSCACHECOLS 33          //grid points across the width of the sheet
+    #define KINEMATICSCACHEROWS 17          //grid points across the height of the sheet
+    #define KINEMATICSCACHESIDES 0.25       //how much closer together the columns are at the sides of the sheet than in the middle, 0 for evenly spaced
+    #define KINEMATICSCACHETOP 0.6          //how much closer together the rows are at the top of the sheet than at the bottom, 0 for evenly spaced
+    #define KINEMATICSCACHEMAXERROR 0.2     //mm, the cache is not used if it can't match the exact solution this well
+    #define KINEMATICSCACHESCALE 1000.0     //cache entries per mm, entries are stored as ints to save RAM
+    #define KINEMATICSCACHEGEOMETRY 14      //number of settings which change the chain lengths
 
     class Kinematics{
         public:
@@ -35,17 +46,42 @@
             void  triangularInverse   (float xTarget,float yTarget, float* aChainLength, float* bChainLength);
             void  recomputeGeometry();
             void  forward(const float& chainALength, const float& chainBLength, float* xPos, float* yPos, float xGuess, float yGuess);
+            #if KINEMATICSCACHE > 0
+            void  updateCache();
+            #endif
             //geometry
             float h; //distance between sled attach point and bit
             float R             = 10.1;                                //sprocket radius
 
             float halfWidth;                      //Half the machine width
             float halfHeight;                    //Half the machine height
+            float cacheError    = -1;             //worst interpolation error of the chain length cache in mm, -1 if not in use
+            int   forwardIterations = 0;          //iterations taken by the last call to forward()
+            float forwardError      = 0;          //largest chain length error in mm left by the last call to forward()
         private:
+            void  _exactInverse(float xTarget,float yTarget, float* aChainLength, float* bChainLength);
+            #if KINEMATICSCACHE > 0
+            void  _cacheGeometry(float* geometry);
+            void  _cachedInverse(float xTarget,float yTarget, float* aChainLength, float* bChainLength);
+            void  _straightChainLengths(const float& xTarget, const float& yTarget, float* aLength, float* bLength);
+            float _cacheColumnX(const int& col);
+            float _cacheRowY(const int& row);
+            bool  _cacheValid = false;
+            unsigned int _cacheBuildStep = 0;                               //next grid point to fill in or check, 0 when there is nothing to do
+            float _cachedGeometry[KINEMATICSCACHEGEOMETRY];                 //the settings the cache was built from
+            float _cacheInvStepX;
+            float _cacheInvStepY;
+            float _cacheOffsetA;
+            float _cacheOffsetB;
+            float _cacheWorstError;
+            int   _cacheA[KINEMATICSCACHEROWS][KINEMATICSCACHECOLS];        //left chain length minus the straight line distance to the left motor
+            int   _cacheB[KINEMATICSCACHEROWS][KINEMATICSCACHECOLS];        //right chain length minus the straight line distance to the right motor
+            #endif
             float _moment(const float& Y1Plus, const float& Y2Plus, const float& MSinPhi, const float& MSinPsi1, const float& MCosPsi1, const float& MSinPsi2, const float& MCosPsi2);
             float _YOffsetEqn(const float& YPlus, const float& Denominator, const float& Psi);
             void  _MatSolv();
             void  _MyTrig();
+            float _atan2(const float& y, const float& x);
             void _verifyValidTarget(float* xTarget,float* yTarget);
             //target router bit coordinates.
             float x = 0;
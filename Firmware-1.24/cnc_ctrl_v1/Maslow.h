@@ -32,14 +32,17 @@
 #include "TimerOne.h"
 #include "Motor.h"
 #include "PID_v1.h"
+#include "PID_fixed.h"
 #include "utility/direct_pin_read.h"
 #include "Encoder.h"
 #include "MotorGearboxEncoder.h"
 #include "Axis.h"
 #include "Kinematics.h"
 #include "RingBuffer.h"
+#include "SPSCRing.h"
 #include "GCode.h"
 #include "Testing.h"
+#include "Planner.h"
 #include "Motion.h"
 #include "Report.h"
 #include "Spindle.h"
@@ -47,6 +50,7 @@
 #include "Settings.h"
 #include "NutsAndBolts.h"
 #include "System.h"
+#include "Profile.h"
 #include "SimavrSerial.h"
 
 #endif
@@ -16,16 +16,38 @@
 
 #include "Maslow.h"
 
-// Flag for when to send movement commands
-volatile bool  movementUpdated  =  false;
+// Setpoints worked out ahead of time by the moves, which are sent to the axes one
+// every LOOPINTERVAL by runsOnATimer().  The moves push() and runsOnATimer() pop().
+typedef struct {
+  float left;                 // Chain lengths in mm
+  float right;
+  float z;                    // Z position in mm
+  byte  axes;                 // Which of the above to use, SETPOINT_LEFT etc.
+  byte  steps;                // Number of PID loops to take getting there
+} setpoint_t;
+SPSCRing<setpoint_t, SETPOINTQUEUESIZE> setpointQueue;
+// The setpoint runsOnATimer() is moving the axes towards, in a straight line in chain space
+setpoint_t     setpointTarget;
+setpoint_t     setpointStep;                 // How far to move each PID loop
+volatile byte  setpointStepsLeft =  0;       // PID loops until setpointTarget is reached
+// Set by each move while it still has setpoints to queue, so runsOnATimer() can tell a
+// move which fell behind from one which has finished
+volatile bool  inMovementLoop     =  false;
 // Global variables for misloop tracking
 #if misloopDebug > 0
-  volatile bool  inMovementLoop   =  false;
   volatile bool  movementFail     =  false;
 #endif
+// Progress through the move at the front of the planner
+float plannedSpeed            = 0;    // mm/s
+float plannedDistanceTraveled = 0;    // mm along the move
 
 void initMotion(){
     // Called on startup or after a stop command
+    motionClearSetpoints();
+    plannerReset();
+    inMovementLoop          = false;
+    plannedSpeed            = 0;
+    plannedDistanceTraveled = 0;
     leftAxis.stop();
     rightAxis.stop();
     if(sysSettings.zAxisAttached){
@@ -59,14 +81,135 @@ float computeStepSize(const float& MMPerMin){
     return LOOPINTERVAL*(MMPerMin/(60 * 1000000));
 }
  
-void movementUpdate(){
+bool  motionSetpointQueueFull(){
+    return setpointQueue.full();
+}
+
+bool  motionSetpointQueueEmpty(){
+    return setpointQueue.empty() && setpointStepsLeft == 0;
+}
+
+void  motionQueueSetpoint(const float& left, const float& right, const float& z, const byte& axes, const byte& steps){
+  /*
+  Adds a setpoint to the queue for runsOnATimer() to send to the axes.  Only the axes
+  in axes are moved.  If steps is more than one the axes are moved there evenly over
+  that many PID loops.  The setpoint is dropped if the queue is full.
+  */
   #if misloopDebug > 0
   if (movementFail){
     Serial.println("Movement loop failed to complete before interrupt.");
     movementFail = false;
   }
   #endif
-  movementUpdated = true;
+  setpoint_t setpoint;
+  setpoint.left  = left;
+  setpoint.right = right;
+  setpoint.z     = z;
+  setpoint.axes  = axes;
+  setpoint.steps = steps;
+  setpointQueue.push(setpoint);
+}
+
+bool  motionRunSetpoint(){
+  /*
+  Sends the next setpoint in the queue, or the next step towards it, to the axes.  Called
+  by runsOnATimer() every LOOPINTERVAL.  Returns false if there wasn't one.  Nothing more is sent once a stop
+  has been called for.
+  */
+  if (sys.stop){
+    setpointQueue.clear();
+    setpointStepsLeft = 0;
+    return false;
+  }
+  if (setpointStepsLeft == 0){
+    if (!setpointQueue.pop(setpointTarget)){
+      return false;
+    }
+    setpointStepsLeft = setpointTarget.steps;
+    if (setpointStepsLeft > 1){
+      float fraction    = 1.0/setpointStepsLeft;
+      setpointStep.left  = (setpointTarget.left  - leftAxis.setpoint())  * fraction;
+      setpointStep.right = (setpointTarget.right - rightAxis.setpoint()) * fraction;
+      setpointStep.z     = (setpointTarget.z     - zAxis.setpoint())     * fraction;
+    }
+  }
+  setpointStepsLeft--;
+  
+  //the last step lands exactly on the setpoint
+  bool last = (setpointStepsLeft == 0);
+  if (setpointTarget.axes & SETPOINT_LEFT){
+    leftAxis.write(last ? setpointTarget.left : leftAxis.setpoint() + setpointStep.left);
+  }
+  if (setpointTarget.axes & SETPOINT_RIGHT){
+    rightAxis.write(last ? setpointTarget.right : rightAxis.setpoint() + setpointStep.right);
+  }
+  if (setpointTarget.axes & SETPOINT_Z){
+    zAxis.write(last ? setpointTarget.z : zAxis.setpoint() + setpointStep.z);
+  }
+  return true;
+}
+
+bool  motionRunControlLoops(){
+    /*
+    The body of runsOnATimer().  Runs the motor speed PID loops every VELOCITYLOOPINTERVAL,
+    and on every VELOCITYLOOPS'th run sends the next setpoint and runs the position PID
+    loops first so the speed loops start from the new target speeds.  Returns true if a
+    new setpoint was sent.
+    */
+    static byte velocityLoops = 0;  // speed loops run since the last position loop
+    bool sent = false;
+    PROFILESTART(PROFILE_TIMER);
+    // Read all three encoders together, then let their interrupts back in
+    // while the PID loops run so no steps are missed
+    noInterrupts();
+    leftAxis.motorGearboxEncoder.snapshotEncoder();
+    rightAxis.motorGearboxEncoder.snapshotEncoder();
+    zAxis.motorGearboxEncoder.snapshotEncoder();
+    interrupts();
+    if (velocityLoops == 0){
+        sent = motionRunSetpoint();
+        if (!sent){
+            #if misloopDebug > 0
+            if (inMovementLoop){
+                movementFail = true;
+            }
+            #endif
+            #if PROFILING > 0
+            if (inMovementLoop){
+                profileOverrun();
+            }
+            #endif
+        }
+        PROFILESTART(PROFILE_LEFTPID);
+        leftAxis.computePID();
+        PROFILEEND(PROFILE_LEFTPID);
+        PROFILESTART(PROFILE_RIGHTPID);
+        rightAxis.computePID();
+        PROFILEEND(PROFILE_RIGHTPID);
+        PROFILESTART(PROFILE_ZPID);
+        zAxis.computePID();
+        PROFILEEND(PROFILE_ZPID);
+    }
+    if (++velocityLoops == VELOCITYLOOPS){
+        velocityLoops = 0;
+    }
+    PROFILESTART(PROFILE_VELOCITYPID);
+    leftAxis.computeVelocityPID();
+    rightAxis.computeVelocityPID();
+    zAxis.computeVelocityPID();
+    PROFILEEND(PROFILE_VELOCITYPID);
+    PROFILEEND(PROFILE_TIMER);
+    return sent;
+}
+
+void  motionClearSetpoints(){
+  /*
+  Throws away any setpoints which haven't been sent to the axes yet
+  */
+  noInterrupts();
+  setpointQueue.clear();
+  setpointStepsLeft = 0;
+  interrupts();
 }
 
 
@@ -76,152 +219,209 @@ int   coordinatedMove(const float& xEnd, const float& yEnd, const float& zEnd, f
     /*The move() function moves the tool in a straight line to the position (xEnd, yEnd) at 
     the speed moveSpeed. Movements are correlated so that regardless of the distances moved in each 
     direction, the tool moves to the target in a straight line. This function is used by the G00 
-    and G01 commands. The units at this point should all be in mm or mm per minute*/
-    
-    float  xStartingLocation = sys.xPosition;
-    float  yStartingLocation = sys.yPosition;
-    float  zStartingLocation = zAxis.read();  // I don't know why we treat the zaxis differently
-    float  zMaxFeed          = sysSettings.maxZRPM * abs(zAxis.getPitch());
-    
-    //find the total distances to move
-    float  distanceToMoveInMM         = sqrt(  sq(xEnd - xStartingLocation)  +  sq(yEnd - yStartingLocation)  + sq(zEnd - zStartingLocation));
-    float  xDistanceToMoveInMM        = xEnd - xStartingLocation;
-    float  yDistanceToMoveInMM        = yEnd - yStartingLocation;
-    float  zDistanceToMoveInMM        = zEnd - zStartingLocation;
-    
-    //compute feed details
-    MMPerMin = constrain(MMPerMin, 1, sysSettings.maxFeed);   //constrain the maximum feedrate, 35ipm = 900 mmpm
-    float  stepSizeMM           = computeStepSize(MMPerMin);
-    float  finalNumberOfSteps   = abs(distanceToMoveInMM/stepSizeMM);
-    float  delayTime            = LOOPINTERVAL;
-    float  zFeedrate            = calculateFeedrate(fabs(zDistanceToMoveInMM/finalNumberOfSteps), delayTime);
-    
-    //throttle back federate if it exceeds zaxis max
-    if (zFeedrate > zMaxFeed){
-      float  zStepSizeMM        = computeStepSize(zMaxFeed);
-      finalNumberOfSteps        = abs(zDistanceToMoveInMM/zStepSizeMM);
-      stepSizeMM                = (distanceToMoveInMM/finalNumberOfSteps);
-      MMPerMin                  = calculateFeedrate(stepSizeMM, delayTime);
-    }
+    and G01 commands. The units at this point should all be in mm or mm per minute
     
-    // (fraction of distance in x direction)* size of step toward target
-    float  xStepSize            = (xDistanceToMoveInMM/finalNumberOfSteps);
-    float  yStepSize            = (yDistanceToMoveInMM/finalNumberOfSteps);
-    float  zStepSize            = (zDistanceToMoveInMM/finalNumberOfSteps);
+    The move is added to the planner and run by executePlannedMoves() so that the machine can
+    carry its speed from one move into the next.  If the planner is full this waits until
+    there is room.*/
     
-    //attach the axes
-    leftAxis.attach();
-    rightAxis.attach();
-    if(sysSettings.zAxisAttached){
-      zAxis.attach();
+    while (plannerIsFull()){
+        executePlannedMoves();
+        execSystemRealtime();
+        if (sys.stop){return 1;}
     }
     
-    float aChainLength;
-    float bChainLength;
-    float zPosition                   = zStartingLocation;
-    long   numberOfStepsTaken         =  0;
+    plannerBufferLine(xEnd, yEnd, zEnd, MMPerMin);
     
-    while(numberOfStepsTaken < finalNumberOfSteps){
-      
-        #if misloopDebug > 0
-        inMovementLoop = true;
-        #endif
-        //if last movment was performed start the next
-        if (!movementUpdated) {
-            //find the target point for this step
-            // This section ~20us
-            sys.xPosition +=  xStepSize;
-            sys.yPosition +=  yStepSize;
-            zPosition += zStepSize;
-            
-            //find the chain lengths for this step
-            // This section ~180us
-            kinematics.inverse(sys.xPosition,sys.yPosition,&aChainLength,&bChainLength);
-            
-            //write to each axis
-            // This section ~180us
-            leftAxis.write(aChainLength);
-            rightAxis.write(bChainLength);
-            if(sysSettings.zAxisAttached){
-              zAxis.write(zPosition);
-            }
-            
-            movementUpdate();
-            
-            //increment the number of steps taken
-            numberOfStepsTaken++;
-            
-            // Run realtime commands
-            execSystemRealtime();
-            if (sys.stop){return 1;}
+    return 1;
+    
+}
+
+byte  _motionCruiseSteps(const planBlock_t* block, const float& speedChange){
+    /*
+    Returns how many steps at the move's feedrate can be run by runsOnATimer() moving the
+    chains at a constant rate, without the tool leaving the straight line by more than
+    ADAPTIVETOLERANCE and without running into the slow down at the end of the move.
+    
+    Along a straight line the length of a chain bends away from a straight line by at most
+    one over its length per mm squared, so the chain lengths are within ADAPTIVETOLERANCE
+    of a straight line over sqrt(8*ADAPTIVETOLERANCE*chain length) mm.
+    */
+    float stepSizeMM = block->nominalSpeed * LOOPINTERVAL / 1000000.0;
+    float chain      = min(leftAxis.setpoint(), rightAxis.setpoint());
+    float straightMM = sqrt(8 * ADAPTIVETOLERANCE * max(chain, 1));
+    
+    //the same limit as maxSpeed in executePlannedMoves(), worked back into a distance
+    float slowDownMM = (sq(block->nominalSpeed + speedChange) - sq(speedChange) - plannerGetExitSpeedSqr()) / (2 * PLANNERACCELERATION);
+    float cruiseMM   = block->millimeters - plannedDistanceTraveled - stepSizeMM - slowDownMM;
+    
+    float steps      = 1 + min(straightMM, cruiseMM) / stepSizeMM;
+    return constrain(steps, 1, 255);
+}
+
+void  executePlannedMoves(){
+    /*
+    
+    Queues the next setpoint of the moves in the planner for the axes.  Does nothing if the
+    setpoint queue is full or if there is nothing to do, so it should be called as often
+    as possible.
+    
+    Each step the speed is increased by PLANNERACCELERATION unless that would be faster than
+    the move's feedrate, or too fast to slow down to the planned speed at the end of the move.
+    
+    With ADAPTIVESTEPS, while the move is cruising at its feedrate several steps are queued
+    as one setpoint, see _motionCruiseSteps().
+    
+    */
+    
+    planBlock_t* block = plannerGetCurrentBlock();
+    if (block == NULL || motionSetpointQueueFull()){
+        return;
+    }
+    PROFILESTART(PROFILE_PLANNER);
+    
+    if (plannedSpeed == 0 && plannedDistanceTraveled == 0){
+        //attach the axes at the start of a move from rest
+        leftAxis.attach();
+        rightAxis.attach();
+        if(sysSettings.zAxisAttached){
+          zAxis.attach();
         }
+        inMovementLoop = true;
     }
-    #if misloopDebug > 0
-    inMovementLoop = false;
-    #endif
     
-    kinematics.inverse(xEnd,yEnd,&aChainLength,&bChainLength);
-    leftAxis.endMove(aChainLength);
-    rightAxis.endMove(bChainLength);
-    if(sysSettings.zAxisAttached){
-      zAxis.endMove(zPosition);
+    //the fastest speed which can still slow down to the exit speed after this step, the
+    //small minimum keeps the last few steps of a move from creeping up on the target
+    const float speedChange = PLANNERACCELERATION * LOOPINTERVAL / 1000000.0;   // mm/s per step
+    float maxSpeed = sqrt(sq(speedChange) + plannerGetExitSpeedSqr() + 2 * PLANNERACCELERATION * (block->millimeters - plannedDistanceTraveled)) - speedChange;
+    plannedSpeed   = max(min(plannedSpeed + speedChange, maxSpeed), speedChange);
+    plannedSpeed   = min(plannedSpeed, block->nominalSpeed);
+    byte steps     = 1;
+    #if ADAPTIVESTEPS > 0
+    if (plannedSpeed == block->nominalSpeed){
+        steps = _motionCruiseSteps(block, speedChange);
+    }
+    #endif
+    plannedDistanceTraveled += steps * plannedSpeed * LOOPINTERVAL / 1000000.0;
+    
+    //carry any distance left over at the end of a move into the next one
+    while (plannedDistanceTraveled >= block->millimeters){
+        plannedDistanceTraveled -= block->millimeters;
+        float xEnd = block->xEnd;
+        float yEnd = block->yEnd;
+        float zEnd = block->zEnd;
+        plannerDiscardCurrentBlock();
+        block = plannerGetCurrentBlock();
+        if (block == NULL){
+            //that was the last move, finish exactly on the target
+            float aChainLength;
+            float bChainLength;
+            kinematics.inverse(xEnd,yEnd,&aChainLength,&bChainLength);
+            motionQueueSetpoint(aChainLength, bChainLength, zEnd, sysSettings.zAxisAttached ? SETPOINT_LEFT | SETPOINT_RIGHT | SETPOINT_Z : SETPOINT_LEFT | SETPOINT_RIGHT);
+            
+            sys.xPosition           = xEnd;
+            sys.yPosition           = yEnd;
+            plannedSpeed            = 0;
+            plannedDistanceTraveled = 0;
+            inMovementLoop          = false;
+            PROFILEEND(PROFILE_PLANNER);
+            return;
+        }
     }
     
-    sys.xPosition = xEnd;
-    sys.yPosition = yEnd;
+    //find the target point for this step, working back from the end of the move
+    float distanceToGo = block->millimeters - plannedDistanceTraveled;
+    sys.xPosition      = block->xEnd - block->xUnit * distanceToGo;
+    sys.yPosition      = block->yEnd - block->yUnit * distanceToGo;
+    float zPosition    = block->zEnd - block->zUnit * distanceToGo;
     
-    return 1;
+    //find the chain lengths for this step
+    float aChainLength;
+    float bChainLength;
+    kinematics.inverse(sys.xPosition,sys.yPosition,&aChainLength,&bChainLength);
     
+    //queue for each axis
+    motionQueueSetpoint(aChainLength, bChainLength, zPosition, sysSettings.zAxisAttached ? SETPOINT_LEFT | SETPOINT_RIGHT | SETPOINT_Z : SETPOINT_LEFT | SETPOINT_RIGHT, steps);
+    PROFILEEND(PROFILE_PLANNER);
+}
+
+void  motionSynchronize(){
+    /*
+    Runs every move in the planner to completion.  Called before any command which has to
+    wait for the machine to finish moving.
+    */
+    while (!plannerIsEmpty() || !motionSetpointQueueEmpty()){
+        executePlannedMoves();
+        
+        // Run realtime commands
+        execSystemRealtime();
+        if (sys.stop){return;}
+    }
+}
+
+float motionProfileSpeed(const float& speed, const float& distanceToGo, const float& nominalSpeed, const float& acceleration){
+    /*
+    Returns the speed in mm/s for the next step of a move which starts and ends at rest.
+    Each step the speed is increased by acceleration, in mm/s^2, until it reaches
+    nominalSpeed, and it is slowed down in time to stop after distanceToGo.  An
+    acceleration of zero or less goes straight to nominalSpeed.
+    */
+    if (acceleration <= 0){
+        return nominalSpeed;
+    }
+    const float speedChange = acceleration * LOOPINTERVAL / 1000000.0;   // mm/s per step
+    float maxSpeed = sqrt(sq(speedChange) + 2 * acceleration * distanceToGo) - speedChange;
+    return min(max(min(speed + speedChange, maxSpeed), speedChange), nominalSpeed);
 }
 
 void  singleAxisMove(Axis* axis, const float& endPos, const float& MMPerMin){
     /*
-    Takes a pointer to an axis object and moves that axis to endPos at speed MMPerMin
+    Takes a pointer to an axis object and moves that axis to endPos at speed MMPerMin,
+    speeding up and slowing down at the acceleration set for the axis
     */
     
     float startingPos          = axis->read();
     float moveDist             = endPos - startingPos; //total distance to move
     
-    float direction            = moveDist/abs(moveDist); //determine the direction of the move
-    
-    float stepSizeMM           = computeStepSize(MMPerMin);                    //step size in mm
-
-    //the argument to abs should only be a variable -- splitting calc into 2 lines
-    long finalNumberOfSteps    = abs(moveDist/stepSizeMM);      //number of steps taken in move
-    finalNumberOfSteps = abs(finalNumberOfSteps);
-    stepSizeMM = stepSizeMM*direction;
+    float direction            = moveDist < 0 ? -1 : 1; //determine the direction of the move
+    float distance             = fabs(moveDist);
     
-    long numberOfStepsTaken    = 0;
+    float nominalSpeed         = MMPerMin / 60.0;                              //speed in mm/s
+    float acceleration         = (axis == &zAxis) ? sysSettings.zAcceleration : sysSettings.chainAcceleration;
+    float speed                = 0;
+    float distanceTraveled     = 0;
     
     //attach the axis we want to move
     axis->attach();
+    byte axisFlag = (axis == &leftAxis) ? SETPOINT_LEFT : (axis == &rightAxis) ? SETPOINT_RIGHT : SETPOINT_Z;
     
-    float whereAxisShouldBeAtThisStep = startingPos;
-    #if misloopDebug > 0
     inMovementLoop = true;
-    #endif
-    while(numberOfStepsTaken < finalNumberOfSteps){
-        if (!movementUpdated) {
-          //find the target point for this step
-          whereAxisShouldBeAtThisStep += stepSizeMM;
+    while(distanceTraveled < distance){
+        if (!motionSetpointQueueFull()) {
+          //find the target point for this step, the last one lands exactly on endPos
+          speed             = motionProfileSpeed(speed, distance - distanceTraveled, nominalSpeed, acceleration);
+          distanceTraveled += speed * LOOPINTERVAL / 1000000.0;
+          float whereAxisShouldBeAtThisStep = (distanceTraveled < distance) ? startingPos + direction * distanceTraveled : endPos;
           
-          //write to axis
-          axis->write(whereAxisShouldBeAtThisStep);
-          movementUpdate();
-          
-          // Run realtime commands
-          execSystemRealtime();
-          if (sys.stop){return;}
-          
-          //increment the number of steps taken
-          numberOfStepsTaken++;
+          //queue for the axis
+          motionQueueSetpoint(whereAxisShouldBeAtThisStep, whereAxisShouldBeAtThisStep, whereAxisShouldBeAtThisStep, axisFlag);
         }
+          
+        // Run realtime commands
+        execSystemRealtime();
+        if (sys.stop){return;}
     }
-    #if misloopDebug > 0
     inMovementLoop = false;
-    #endif
     
-    axis->endMove(endPos);
+    if (axis == &zAxis){
+        plannerSetZPosition(endPos);
+    }
+    
+    //the callers go on to read the axis so wait for it to get there
+    while (!motionSetpointQueueEmpty()){
+        execSystemRealtime();
+        if (sys.stop){return;}
+    }
     
 }
 
@@ -235,12 +435,15 @@ int   arc(const float& X1, const float& Y1, const float& Z1, const float& X2, co
     Move the machine through an arc from point (X1, Y1) to point (X2, Y2) along the 
     arc defined by center (centerX, centerY) at speed MMPerMin
     
+    Each step turns the vector from the center to the machine by the same small angle,
+    which only takes a few multiplications.  The rounding error this builds up is thrown
+    away every ARCCORRECTION steps by working the point out again with sin() and cos().
+    
     */
     
     //compute geometry 
-    float pi                     =  3.1415;
+    float pi                     =  3.14159265;
     float radius                 =  sqrt( sq(centerX - X1) + sq(centerY - Y1) ); 
-    float circumference          =  2.0*pi*radius;
     
     float startingAngle          =  atan2(Y1 - centerY, X1 - centerX);
     float endingAngle            =  atan2(Y2 - centerY, X2 - centerX);
@@ -275,7 +478,7 @@ int   arc(const float& X1, const float& Y1, const float& Z1, const float& X2, co
       return 1;
     }
 
-    float arcLengthMM             = fabs(circumference * (theta / (2*pi) ));
+    float arcLengthMM             = fabs(radius * theta);
     float zDistanceToMoveInMM     = Z2 - Z1;
     
     //set up variables for movement
@@ -301,13 +504,22 @@ int   arc(const float& X1, const float& Y1, const float& Z1, const float& X2, co
     
     zStepSizeMM = zDistanceToMoveInMM/finalNumberOfSteps;
 
-    //Compute the starting position
-    float angleNow = startingAngle;
-    float degreeComplete = 0.0;
+    //Compute the rotation made by each step, sin() and cos() are close enough to the
+    //first terms of their series for such small angles
+    float thetaPerStep   = theta/finalNumberOfSteps;
+    float cosThetaPerStep = 2.0 - sq(thetaPerStep);
+    float sinThetaPerStep = thetaPerStep*0.16666667*(cosThetaPerStep + 4.0);
+    cosThetaPerStep      *= 0.5;
+    
+    //Compute the starting position relative to the center
+    float radiusX        = X1 - centerX;
+    float radiusY        = Y1 - centerY;
+    float rotatedX;
+    byte  stepsSinceCorrection = 0;
     
     float aChainLength;
     float bChainLength;
-    float zPosition      = Z1 + zStepSizeMM;
+    float zPosition      = Z1;
     
     //attach the axes
     leftAxis.attach();
@@ -316,48 +528,52 @@ int   arc(const float& X1, const float& Y1, const float& Z1, const float& X2, co
       zAxis.attach();
     }
     
-    while(numberOfStepsTaken < abs(finalNumberOfSteps)){
-        #if misloopDebug > 0
-        inMovementLoop = true;
-        #endif
+    //the last step is the end point itself, which is queued after the loop
+    inMovementLoop = true;
+    while(numberOfStepsTaken < finalNumberOfSteps - 1){
         
-        //if last movement was performed start the next one
-        if (!movementUpdated){
+        //if there is room in the queue work out the next setpoint
+        if (!motionSetpointQueueFull()){
             
-            degreeComplete = float(numberOfStepsTaken)/float(finalNumberOfSteps);
+            numberOfStepsTaken++;
             
-            angleNow = startingAngle + theta*direction*degreeComplete;
+            if (stepsSinceCorrection < ARCCORRECTION){
+                rotatedX = radiusX*cosThetaPerStep - radiusY*sinThetaPerStep;
+                radiusY  = radiusX*sinThetaPerStep + radiusY*cosThetaPerStep;
+                radiusX  = rotatedX;
+                stepsSinceCorrection++;
+            }
+            else {
+                float angleNow = startingAngle + numberOfStepsTaken*thetaPerStep;
+                radiusX  = radius * cos(angleNow);
+                radiusY  = radius * sin(angleNow);
+                stepsSinceCorrection = 0;
+            }
             
-            sys.xPosition = radius * cos(angleNow) + centerX;
-            sys.yPosition = radius * sin(angleNow) + centerY;
+            sys.xPosition = centerX + radiusX;
+            sys.yPosition = centerY + radiusY;
+            zPosition    += zStepSizeMM;
     
             kinematics.inverse(sys.xPosition,sys.yPosition,&aChainLength,&bChainLength);
             
-            leftAxis.write(aChainLength);
-            rightAxis.write(bChainLength); 
-            if(sysSettings.zAxisAttached){
-              zAxis.write(zPosition);
-            }
-            movementUpdate();
-            
-            // Run realtime commands
-            execSystemRealtime();
-            if (sys.stop){return 1;}
-
-            numberOfStepsTaken++;
-            zPosition += zStepSizeMM;
+            motionQueueSetpoint(aChainLength, bChainLength, zPosition, sysSettings.zAxisAttached ? SETPOINT_LEFT | SETPOINT_RIGHT | SETPOINT_Z : SETPOINT_LEFT | SETPOINT_RIGHT);
         }
+            
+        // Run realtime commands
+        execSystemRealtime();
+        if (sys.stop){return 1;}
     }
-    #if misloopDebug > 0
-    inMovementLoop = false;
-    #endif
-    
     kinematics.inverse(X2,Y2,&aChainLength,&bChainLength);
-    leftAxis.endMove(aChainLength);
-    rightAxis.endMove(bChainLength);
+    while (motionSetpointQueueFull()){
+        execSystemRealtime();
+        if (sys.stop){return 1;}
+    }
+    motionQueueSetpoint(aChainLength, bChainLength, Z2, sysSettings.zAxisAttached ? SETPOINT_LEFT | SETPOINT_RIGHT | SETPOINT_Z : SETPOINT_LEFT | SETPOINT_RIGHT);
+    inMovementLoop = false;
     
     sys.xPosition = X2;
     sys.yPosition = Y2;
+    plannerSetZPosition(Z2);
     
     return 1;
 }
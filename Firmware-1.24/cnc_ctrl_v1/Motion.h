@@ -17,20 +17,32 @@
 #ifndef motion_h
 #define motion_h
 
+// The axes a setpoint is for
+#define SETPOINT_LEFT  bit(0)
+#define SETPOINT_RIGHT bit(1)
+#define SETPOINT_Z     bit(2)
+
 // These are used for movement tracking and need to be available to the ISR
-extern volatile bool movementUpdated;
+extern volatile bool  inMovementLoop;
 #if misloopDebug > 0
-  extern volatile bool  inMovementLoop;
   extern volatile bool  movementFail;
 #endif
 
 void initMotion();
 int   coordinatedMove(const float&, const float&, const float&, float);
+void  executePlannedMoves();
+void  motionSynchronize();
 void  singleAxisMove(Axis*, const float&, const float&);
 int   arc(const float&, const float&, const float&, const float&, const float&, const float&, const float&, const float&, const float&, const float&);
 float calculateFeedrate(const float&, const float&);
 float computeStepSize(const float&);
-void movementUpdate();
+float motionProfileSpeed(const float&, const float&, const float&, const float&);
+bool  motionSetpointQueueFull();
+bool  motionSetpointQueueEmpty();
+void  motionQueueSetpoint(const float&, const float&, const float&, const byte&, const byte& steps = 1);
+bool  motionRunSetpoint();
+bool  motionRunControlLoops();
+void  motionClearSetpoints();
 void motionDetachIfIdle();
 
 #endif
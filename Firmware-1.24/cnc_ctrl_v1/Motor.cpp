@@ -57,9 +57,166 @@ int  Motor::setupMotor(const int& pwmPin, const int& pin1, const int& pin2){
     digitalWrite(_pin1,    LOW);
     digitalWrite(_pin2,    LOW) ;
   }
+  _setupPin(_pwmPinPort, _pwmPin);
+  _setupPin(_pin1Port, _pin1);
+  _setupPin(_pin2Port, _pin2);
+  _setupDrives();
   return 1;
 }
 
+void Motor::_setupPin(MotorPin& pin, const int& pinNumber){
+    /*
+    Looks up the registers for a pin, the same way digitalWrite() and analogWrite()
+    do every time they are called
+    */
+    pin.port  = portOutputRegister(digitalPinToPort(pinNumber));
+    pin.bit   = digitalPinToBitMask(pinNumber);
+    pin.tccr  = NULL;
+    pin.com   = 0;
+    pin.ocr8  = NULL;
+    pin.ocr16 = NULL;
+    switch (digitalPinToTimer(pinNumber)){
+        #if defined(TCCR0A) && defined(COM0A1)
+        case TIMER0A: pin.tccr = &TCCR0A; pin.com = _BV(COM0A1); pin.ocr8  = &OCR0A; break;
+        #endif
+        #if defined(TCCR0A) && defined(COM0B1)
+        case TIMER0B: pin.tccr = &TCCR0A; pin.com = _BV(COM0B1); pin.ocr8  = &OCR0B; break;
+        #endif
+        #if defined(TCCR1A) && defined(COM1A1)
+        case TIMER1A: pin.tccr = &TCCR1A; pin.com = _BV(COM1A1); pin.ocr16 = &OCR1A; break;
+        #endif
+        #if defined(TCCR1A) && defined(COM1B1)
+        case TIMER1B: pin.tccr = &TCCR1A; pin.com = _BV(COM1B1); pin.ocr16 = &OCR1B; break;
+        #endif
+        #if defined(TCCR1A) && defined(COM1C1)
+        case TIMER1C: pin.tccr = &TCCR1A; pin.com = _BV(COM1C1); pin.ocr16 = &OCR1C; break;
+        #endif
+        #if defined(TCCR2A) && defined(COM2A1)
+        case TIMER2A: pin.tccr = &TCCR2A; pin.com = _BV(COM2A1); pin.ocr8  = &OCR2A; break;
+        #endif
+        #if defined(TCCR2A) && defined(COM2B1)
+        case TIMER2B: pin.tccr = &TCCR2A; pin.com = _BV(COM2B1); pin.ocr8  = &OCR2B; break;
+        #endif
+        #if defined(TCCR3A) && defined(COM3A1)
+        case TIMER3A: pin.tccr = &TCCR3A; pin.com = _BV(COM3A1); pin.ocr16 = &OCR3A; break;
+        #endif
+        #if defined(TCCR3A) && defined(COM3B1)
+        case TIMER3B: pin.tccr = &TCCR3A; pin.com = _BV(COM3B1); pin.ocr16 = &OCR3B; break;
+        #endif
+        #if defined(TCCR3A) && defined(COM3C1)
+        case TIMER3C: pin.tccr = &TCCR3A; pin.com = _BV(COM3C1); pin.ocr16 = &OCR3C; break;
+        #endif
+        #if defined(TCCR4A) && defined(COM4A1)
+        case TIMER4A: pin.tccr = &TCCR4A; pin.com = _BV(COM4A1); pin.ocr16 = &OCR4A; break;
+        #endif
+        #if defined(TCCR4A) && defined(COM4B1)
+        case TIMER4B: pin.tccr = &TCCR4A; pin.com = _BV(COM4B1); pin.ocr16 = &OCR4B; break;
+        #endif
+        #if defined(TCCR4A) && defined(COM4C1)
+        case TIMER4C: pin.tccr = &TCCR4A; pin.com = _BV(COM4C1); pin.ocr16 = &OCR4C; break;
+        #endif
+        #if defined(TCCR5A) && defined(COM5A1)
+        case TIMER5A: pin.tccr = &TCCR5A; pin.com = _BV(COM5A1); pin.ocr16 = &OCR5A; break;
+        #endif
+        #if defined(TCCR5A) && defined(COM5B1)
+        case TIMER5B: pin.tccr = &TCCR5A; pin.com = _BV(COM5B1); pin.ocr16 = &OCR5B; break;
+        #endif
+        #if defined(TCCR5A) && defined(COM5C1)
+        case TIMER5C: pin.tccr = &TCCR5A; pin.com = _BV(COM5C1); pin.ocr16 = &OCR5C; break;
+        #endif
+        default: break;
+    }
+}
+
+void Motor::_setupDrives(){
+    /*
+    Works out which pin carries the PWM signal in each direction and how the other
+    pins are set.  Pins 4 and 13 are on timer0 and pins 11 and 12 on timer1, which
+    are used for millis() and the PID loop, so they are not used for PWM if it
+    can be avoided.
+    */
+    bool usePin1 = ((_pin1 != 4) && (_pin1 != 13) && (_pin1 != 11) && (_pin1 != 12));
+    bool usePin2 = ((_pin2 != 4) && (_pin2 != 13) && (_pin2 != 11) && (_pin2 != 12));
+    bool usepwmPin = ((TLE5206 == false) && (_pwmPin != 4) && (_pwmPin != 13) && (_pwmPin != 11) && (_pwmPin != 12));
+    if (!TLE5206) {
+        if (usepwmPin){
+            _forward = {&_pwmPinPort, false, {&_pin1Port, &_pin2Port},   {HIGH, LOW}};
+            _reverse = {&_pwmPinPort, false, {&_pin2Port, &_pin1Port},   {HIGH, LOW}};
+        }
+        else {
+            if (usePin2){
+                _forward = {&_pin2Port, true,  {&_pin1Port, &_pwmPinPort}, {HIGH, HIGH}}; // invert drive signals - don't alter speed
+            }
+            else {
+                _forward = {&_pin1Port, false, {&_pin2Port, &_pwmPinPort}, {LOW, HIGH}};
+            }
+            if (usePin1){
+                _reverse = {&_pin1Port, true,  {&_pin2Port, &_pwmPinPort}, {HIGH, HIGH}}; // invert drive signals - don't alter speed
+            }
+            else {
+                _reverse = {&_pin2Port, false, {&_pin1Port, &_pwmPinPort}, {LOW, HIGH}};
+            }
+        }
+    }
+    else { // TLE5206
+        if (usePin2){
+            _forward = {&_pin2Port, true,  {&_pin1Port, NULL}, {HIGH, LOW}};
+        }
+        else {
+            _forward = {&_pin1Port, false, {&_pin2Port, NULL}, {LOW, LOW}};
+        }
+        if (usePin1){
+            _reverse = {&_pin1Port, true,  {&_pin2Port, NULL}, {HIGH, LOW}};
+        }
+        else {
+            _reverse = {&_pin2Port, false, {&_pin1Port, NULL}, {LOW, LOW}};
+        }
+    }
+}
+
+void Motor::_pinWrite(MotorPin& pin, const bool& level){
+    /*
+    Does what digitalWrite() does, without looking the pin up.  The port is shared
+    with other pins so interrupts are held off while it changes.
+    */
+    byte oldSREG = SREG;
+    cli();
+    if (pin.tccr != NULL){
+        *pin.tccr &= ~pin.com;  // stop any PWM on the pin
+    }
+    if (level){
+        *pin.port |= pin.bit;
+    }
+    else {
+        *pin.port &= ~pin.bit;
+    }
+    SREG = oldSREG;
+}
+
+void Motor::_pwmWrite(MotorPin& pin, const int& value){
+    /*
+    Does what analogWrite() does, without looking the pin up
+    */
+    if (value <= 0 || (pin.tccr == NULL && value < 128)){
+        _pinWrite(pin, LOW);
+    }
+    else if (value >= 255 || pin.tccr == NULL){
+        _pinWrite(pin, HIGH);
+    }
+    else {
+        byte oldSREG = SREG;
+        cli();
+        *pin.tccr |= pin.com;
+        if (pin.ocr8 != NULL){
+            *pin.ocr8 = value;
+        }
+        else {
+            *pin.ocr16 = value;
+        }
+        SREG = oldSREG;
+    }
+}
+
 void Motor::attach(){
     _attachedState = 1;
 }
@@ -103,72 +260,12 @@ void Motor::write(int speed, bool force){
         bool forward = (speed > 0);
         speed = abs(speed); //remove sign from input because direction is set by control pins on H-bridge
 
-        bool usePin1 = ((_pin1 != 4) && (_pin1 != 13) && (_pin1 != 11) && (_pin1 != 12)); // avoid PWM using timer0 or timer1
-        bool usePin2 = ((_pin2 != 4) && (_pin2 != 13) && (_pin2 != 11) && (_pin2 != 12)); // avoid PWM using timer0 or timer1
-        bool usepwmPin = ((TLE5206 == false) && (_pwmPin != 4) && (_pwmPin != 13) && (_pwmPin != 11) && (_pwmPin != 12)); // avoid PWM using timer0 or timer1       
-        if (!TLE5206) {
-            if (forward){
-                if (usepwmPin){
-                    digitalWrite(_pin1 , HIGH );
-                    digitalWrite(_pin2 ,  LOW  );
-                    analogWrite(_pwmPin, speed);
-                }
-                else if (usePin2) {
-                    digitalWrite(_pin1 , HIGH );
-                    analogWrite(_pin2 , 255 - speed); // invert drive signals - don't alter speed
-                    digitalWrite(_pwmPin, HIGH);
-                }
-                else{
-                    analogWrite(_pin1 , speed);
-                    digitalWrite(_pin2 , LOW );
-                    digitalWrite(_pwmPin, HIGH);
-                }
-            }
-            else { // reverse or zero speed
-                if (usepwmPin){
-                    digitalWrite(_pin2 , HIGH);
-                    digitalWrite(_pin1 , LOW );
-                    analogWrite(_pwmPin, speed);
-                }
-                else if (usePin1) {
-                    analogWrite(_pin1 , 255 - speed); // invert drive signals - don't alter speed
-                    digitalWrite(_pin2 , HIGH );
-                    digitalWrite(_pwmPin, HIGH);
-                }
-                else {
-                    analogWrite(_pin2 , speed);
-                    digitalWrite(_pin1 , LOW );
-                    digitalWrite(_pwmPin, HIGH);
-                }
-            }
-        } 
-        else { // TLE5206
-            if (forward) {
-                if (speed > 0) {
-                    if (usePin2) {
-                        digitalWrite(_pin1 , HIGH );
-                        analogWrite(_pin2 , 255 - speed); // invert drive signals - don't alter speed
-                    } 
-                    else {
-                        analogWrite(_pin1 , speed);
-                        digitalWrite(_pin2 , LOW );
-                    }
-                } 
-                else { // speed = 0 so put on the brakes
-                    digitalWrite(_pin1 , LOW );
-                    digitalWrite(_pin2 , LOW );
-                }
-            } 
-            else { // reverse
-                if (usePin1) {
-                    analogWrite(_pin1 , 255 - speed); // invert drive signals - don't alter speed
-                    digitalWrite(_pin2 , HIGH );
-                } else {
-                    analogWrite(_pin2 , speed);
-                    digitalWrite(_pin1 , LOW );
-                }
-            }
+        MotorDrive& drive = forward ? _forward : _reverse;
+        _pinWrite(*drive.pins[0], drive.levels[0]);
+        if (drive.pins[1] != NULL){
+            _pinWrite(*drive.pins[1], drive.levels[1]);
         }
+        _pwmWrite(*drive.pwm, drive.inverted ? 255 - speed : speed);
     }
 }
 
@@ -29,6 +29,25 @@
     
     
     
+    // A pin the motor drives, looked up once by setupMotor() so that write()
+    // can set it straight through the port and timer registers
+    struct MotorPin{
+        volatile uint8_t*  port;          // output register of the pin
+        uint8_t            bit;           // mask of the pin in port
+        volatile uint8_t*  tccr;          // control register of the timer which can PWM the pin, NULL if none
+        uint8_t            com;           // mask of the bit in tccr which connects the pin to the timer
+        volatile uint8_t*  ocr8;          // compare register of the timer, 8 or 16 bits
+        volatile uint16_t* ocr16;
+    };
+    
+    // How the pins are driven in one direction, worked out by setupMotor()
+    struct MotorDrive{
+        MotorPin*  pwm;                   // the pin given the speed
+        bool       inverted;              // if the pin is given 255 - speed
+        MotorPin*  pins[2];               // the other pins set for this direction, the second may be NULL
+        bool       levels[2];
+    };
+    
     class Motor{
         public:
             Motor();
@@ -41,9 +60,18 @@
             int  attached();
             void  directWrite(int voltage);
         private:
+            void _setupPin(MotorPin& pin, const int& pinNumber);
+            void _setupDrives();
+            void _pinWrite(MotorPin& pin, const bool& level);
+            void _pwmWrite(MotorPin& pin, const int& value);
             int _pwmPin;
             int _pin1;
             int _pin2;
+            MotorPin   _pwmPinPort;
+            MotorPin   _pin1Port;
+            MotorPin   _pin2Port;
+            MotorDrive _forward;
+            MotorDrive _reverse;
             bool _attachedState = false;
             LinSegment _linSegments[4];
             int _lastSpeed  = 0;
@@ -23,7 +23,7 @@ to be a drop in replacement for a continuous rotation servo.
 
 #include "Maslow.h"
 
-void MotorGearboxEncoder::setup(const int& pwmPin, const int& directionPin1, const int& directionPin2, const int& encoderPin1, const int& encoderPin2, const unsigned long& loopInterval)
+void MotorGearboxEncoder::setup(const int& pwmPin, const int& directionPin1, const int& directionPin2, const int& encoderPin1, const int& encoderPin2, const unsigned long& loopInterval, const bool& fixedPointPID)
 {
     //initialize encoder
     encoder.setup(encoderPin1,encoderPin2);
@@ -36,7 +36,10 @@ void MotorGearboxEncoder::setup(const int& pwmPin, const int& directionPin1, con
     motor.setupMotor(pwmPin, directionPin1, directionPin2);
     motor.write(0);
     
-    //initialize the PID
+    //initialize the PID, in fixed point if FIXEDVELOCITYPID chose this axis
+    #if FIXEDVELOCITYPID > 0
+    _PIDController.useFixedPoint(fixedPointPID);
+    #endif
     _PIDController.setup(&_currentSpeed, &_pidOutput, &_targetSpeed, _Kp, _Ki, _Kd, &one, DIRECT);
     initializePID(loopInterval);
     
@@ -129,57 +132,60 @@ void MotorGearboxEncoder::setEncoderResolution(float resolution){
     
 }
 
+void MotorGearboxEncoder::snapshotEncoder(){
+    /*
+    Reads the encoder into encoderSnapshot, which computeSpeed() and the axis
+    position PID work from.  Interrupts are put back how they were found so
+    runsOnATimer() can read all three encoders with them off just the once.
+    */
+    byte oldSREG = SREG;
+    cli();
+    encoder.snapshot(&encoderSnapshot);
+    SREG = oldSREG;
+}
+
 float MotorGearboxEncoder::computeSpeed(){
     /*
     
-    Returns the motors speed in RPM since the last time this function was called
-    should only be called by the PID process otherwise we are calculating the
-    distance moved over a varying amount of time.
+    Returns the motors speed in RPM as of the last snapshotEncoder(), should
+    only be called by the PID process otherwise the speed is measured over a
+    varying amount of time.
+    
+    The speed is the number of steps between the last step seen now and the one
+    seen SPEEDWINDOW - 1 calls ago divided by the time between those two steps,
+    which the encoder interrupt records exactly.  That leaves none of the noise
+    of counting whole steps in a fixed time.  When the motor has not stepped in
+    that time the time between its last two steps is used, and as the motor
+    slows the time since its last step limits the speed so it can reach 0.
     
     */
     
-    float currentPosition = encoder.read();
-    float currentMicros = micros();
-    
-    float distMoved   =  currentPosition - _lastPosition;
-    if (distMoved > 3 || distMoved < -3){
-      
-        // This dampens some of the effects of quantization without having 
-        // a big effect on other changes
-        float saveDistMoved = distMoved;
-        if (distMoved - _lastDistMoved <= -1){ distMoved += .5;}
-        else if (distMoved - _lastDistMoved >= 1){distMoved -= .5;}
-        _lastDistMoved = saveDistMoved;
-        
-        unsigned long timeElapsed =  currentMicros - _lastTimeStamp;
-        //Compute the speed in RPM
-        _RPM = (_encoderStepsToRPMScaleFactor*distMoved)/float(timeElapsed);
+    int32_t position    = encoderSnapshot.position;
+    int32_t lastTime    = encoderSnapshot.lastTime;
+    int32_t elapsedTime = encoderSnapshot.elapsedTime;
     
+    int32_t steps    = position - _windowPosition[_windowOldest];
+    int32_t stepTime = lastTime - _windowTime[_windowOldest];
+    _windowPosition[_windowOldest] = position;
+    _windowTime[_windowOldest]     = lastTime;
+    if (++_windowOldest == SPEEDWINDOW){
+        _windowOldest = 0;
     }
-    else {
-        float elapsedTime = encoder.elapsedTime();
-        float lastTime = micros() - encoder.lastStepTime();  // no direction associated with this
-        if (lastTime > abs(elapsedTime)) {
-            // This allows the RPM to approach 0
-            if (elapsedTime < 0){
-                elapsedTime = -lastTime;
-            }
-            else {
-                elapsedTime = lastTime;
-            }
-        };
-
-        _RPM = 0 ;
-        if (elapsedTime != 0){
-          _RPM = _encoderStepsToRPMScaleFactor / elapsedTime;
-        }
+    
+    float stepPeriod = elapsedTime;  // signed by the direction of the steps
+    if (steps != 0 && stepTime > 0){
+        stepPeriod = float(stepTime) / steps;
+    }
+    float sinceLastStep = (unsigned long)(micros() - lastTime);
+    if (sinceLastStep > abs(stepPeriod)){
+        stepPeriod = stepPeriod < 0 ? -sinceLastStep : sinceLastStep;
+    }
+    _RPM = 0;
+    if (stepPeriod != 0){
+        _RPM = _encoderStepsToRPMScaleFactor / stepPeriod;
     }
     _RPM = _RPM * -1.0;
     
-    //Store values for next time
-    _lastTimeStamp = currentMicros;
-    _lastPosition  = currentPosition;
-    
     return _RPM;
 }
 
@@ -20,8 +20,10 @@
     
     class MotorGearboxEncoder{
         public:
-            void setup(const int& pwmPin, const int& directionPin1, const int& directionPin2, const int& encoderPin1, const int& encoderPin2, const unsigned long& loopInterval);
+            void setup(const int& pwmPin, const int& directionPin1, const int& directionPin2, const int& encoderPin1, const int& encoderPin2, const unsigned long& loopInterval, const bool& fixedPointPID = false);
             Encoder    encoder;
+            encoderSnapshot_t encoderSnapshot;  // the encoder as of the last snapshotEncoder()
+            void       snapshotEncoder();
             Motor      motor;
             float      cachedSpeed();
             void       write(const float& speed);
@@ -38,13 +40,17 @@
         private:
             double     _targetSpeed;
             double     _currentSpeed;
-            volatile double     _lastPosition;
-            volatile double     _lastTimeStamp;
-            float               _lastDistMoved;
-            float               _RPM;
+            int32_t    _windowPosition[SPEEDWINDOW];   // encoder position and the time of its
+            int32_t    _windowTime[SPEEDWINDOW];       // last step, each run of computeSpeed()
+            byte       _windowOldest = 0;
+            float      _RPM;
             char       *_motorName;
             double     _pidOutput;
+            #if FIXEDVELOCITYPID > 0
+            SelectablePID _PIDController;
+            #else
             PID        _PIDController;
+            #endif
             float      *_Kp, *_Ki, *_Kd;
             // This could be converted to a pointer to save 4 bytes, but the
             // calculation would have to be done at a much higher level and 
@@ -29,39 +29,50 @@ float readFloat(const String& str, byte& index, float& retVal){
     appear to handle scientific notation or hexadecimal notation, or some other 
     type of numerical representation that we don't want supported.
     */
+    return readFloat(str.c_str(), index, retVal);
+}
+
+float readFloat(const char* str, byte& index, float& retVal){
+    /*
+    The same as above, but reads from a null terminated char array so that it can
+    be used without making a String.  Only the first nine significant digits are
+    kept, which is more than a float can hold, so that the long they are added up
+    in can't overflow.
+    */
     bool isNegative = false;
     bool isFraction = false;
     long value = 0;
     float fraction = 1.0;
     byte ndigit = 0;
-    while (str[index] == ' ' && index < str.length()){
+    while (str[index] == ' '){
       index++;
     }
     do{
-      if (index < str.length()){
+      if (str[index] != '\0'){
         if(str[index] == '-')
           isNegative = true;
         else if (str[index] == '.')
           isFraction = true;
         else if(str[index] >= '0' && str[index] <= '9')  {// is a digit?
           ndigit++;
-          value = value * 10 + str[index] - '0';
-          if(isFraction)
-             fraction *= 0.1;
+          if (value < 100000000L){
+            value = value * 10 + str[index] - '0';
+            if(isFraction)
+               fraction *= 0.1;
+          }
+          else if (!isFraction)
+            fraction *= 10.0;                        // a digit too many to keep only moves the point
         }
         index++;
       }
     }
-    while(((str[index] >= '0' && str[index] <= '9')  || (str[index] == '.' && !isFraction)) && index < str.length());
+    while((str[index] >= '0' && str[index] <= '9')  || (str[index] == '.' && !isFraction));
 
     if (!ndigit) { return false; };
 
     if(isNegative)
       value = -value;
-    if(isFraction)
-      retVal = value * fraction;
-    else
-      retVal = value;
+    retVal = value * fraction;
 
     return true;
-}
\ No newline at end of file
+}
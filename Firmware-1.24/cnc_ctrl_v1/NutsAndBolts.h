@@ -27,5 +27,6 @@ Copyright 2014-2017 Bar Smith*/
 #define bit_isfalse(x,mask) ((x & mask) == 0)
 
 float readFloat(const String&, byte&, float&);
+float readFloat(const char*, byte&, float&);
 
 #endif 
\ No newline at end of file
@@ -0,0 +1,268 @@
+/*This file is part of the Maslow Control Software.
+    The Maslow Control Software is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    Maslow Control Software is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with the Maslow Control Software.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2014-2017 Bar Smith*/
+
+// The same controller as PID_v1, see there for how it works, in 16.16 fixed point
+
+#include "Maslow.h"
+
+#define FIXEDONE 65536L         // 1.0 in 16.16
+#define FIXEDMAX 2147483647L    // the largest 16.16 value, just under 32768.0, results saturate at +/- this
+
+FixedPID::FixedPID()
+{
+    inAuto = false;
+}
+
+void FixedPID::setup(volatile double* Input, volatile double* Output, volatile double* Setpoint,
+        float* Kp, float* Ki, float* Kd, float* POn, const int& ControllerDirection)
+{
+    myOutput = Output;
+    myInput = Input;
+    mySetpoint = Setpoint;
+    inAuto = false;
+    outputSum = 0;
+    lastInput = 0;
+
+    SetOutputLimits(0, 255);
+
+    SampleTime = 100;
+
+    SetControllerDirection(ControllerDirection);
+    SetTunings(Kp, Ki, Kd, POn);
+}
+
+bool FixedPID::Compute()
+{
+    /*
+    Works out a new output, always called at the sample time by the timer
+    interrupt.  Everything is done in 32 bits, every sum and product saturates
+    instead of wrapping around so a large error still pushes the output the
+    right way.
+    */
+    if(!inAuto) return false;
+
+    int32_t input = _toFixed(*myInput);
+    int32_t error = _subtract(_toFixed(*mySetpoint), input);
+    int32_t dInput = _subtract(input, lastInput);
+
+    int32_t sum = _add(outputSum, _multiply(ki, error));
+    if(pOnM) sum = _subtract(sum, _multiply(pOnMKp, dInput));
+    outputSum = _clamp(sum);
+
+    int32_t output = 0;
+    if(pOnE) output = _multiply(pOnEKp, error);
+    output = _add(output, _subtract(outputSum, _multiply(kd, dInput)));
+    *myOutput = _toDouble(_clamp(output));
+
+    lastInput = input;
+    return true;
+}
+
+void FixedPID::SetTunings(float* Kp, float* Ki, float* Kd, float* pOn)
+{
+    if (*Kp<0 || *Ki<0 || *Kd<0 || *pOn<0 || *pOn>1) return;
+
+    pOnE = *pOn>0;
+    pOnM = *pOn<1;
+
+    dispKp = Kp; dispKi = Ki; dispKd = Kd;
+
+    double SampleTimeInSec = ((double)SampleTime)/1000;
+    double sign = (controllerDirection == REVERSE) ? -1 : 1;
+    kp = _toFixed(sign * *Kp);
+    ki = _toFixed(sign * *Ki * SampleTimeInSec);
+    kd = _toFixed(sign * *Kd / SampleTimeInSec);
+    pOnEKp = _toFixed(sign * *pOn * *Kp);
+    pOnMKp = _toFixed(sign * (1 - *pOn) * *Kp);
+}
+
+void FixedPID::SetSampleTime(const int& NewSampleTime)
+{
+    /*
+    Sets the period in milliseconds.  Rescaled in floating point so the
+    integral and derivative tunings don't lose precision each time.
+    */
+    if (NewSampleTime > 0)
+    {
+        double ratio = (double)NewSampleTime / (double)SampleTime;
+        ki = _toFixed(_toDouble(ki) * ratio);
+        kd = _toFixed(_toDouble(kd) / ratio);
+        SampleTime = (unsigned long)NewSampleTime;
+    }
+}
+
+void FixedPID::SetOutputLimits(const double& Min, const double& Max)
+{
+    if(Min >= Max) return;
+    outMin = _toFixed(Min);
+    outMax = _toFixed(Max);
+
+    if(inAuto)
+    {
+        *myOutput = _toDouble(_clamp(_toFixed(*myOutput)));
+        outputSum = _clamp(outputSum);
+    }
+}
+
+void FixedPID::SetMode(const int& Mode)
+{
+    bool newAuto = (Mode == AUTOMATIC);
+    if(newAuto && !inAuto)
+    {
+        Initialize();
+    }
+    inAuto = newAuto;
+}
+
+void FixedPID::Initialize()
+{
+    outputSum = _clamp(_toFixed(*myOutput));
+    lastInput = _toFixed(*myInput);
+}
+
+void FixedPID::SetControllerDirection(const int& Direction)
+{
+    if(inAuto && Direction != controllerDirection)
+    {
+        kp = -kp;
+        ki = -ki;
+        kd = -kd;
+        pOnEKp = -pOnEKp;
+        pOnMKp = -pOnMKp;
+    }
+    controllerDirection = Direction;
+}
+
+double FixedPID::GetKp(){ return  *dispKp;}
+double FixedPID::GetKi(){ return  *dispKi;}
+double FixedPID::GetKd(){ return  *dispKd;}
+int FixedPID::GetMode(){ return  inAuto ? AUTOMATIC : MANUAL;}
+int FixedPID::GetDirection(){ return controllerDirection;}
+double FixedPID::GetIterm(){ return _toDouble(outputSum); }
+
+String FixedPID::pidState() {
+    /*
+    Returns a comma seperated string of the PID setpoint, input, & output
+    useful for debugging
+    */
+    double input = *myInput;
+    double setpoint = *mySetpoint;
+    double output = *myOutput;
+    String ret = "";
+    ret.concat((double)setpoint);
+    ret.concat(",");
+    ret.concat((double)input);
+    ret.concat(",");
+    ret.concat((double)output);
+    return ret;
+}
+
+int32_t FixedPID::_toFixed(double value){
+    value *= FIXEDONE;
+    if(value >= FIXEDMAX) return FIXEDMAX;
+    if(value <= -FIXEDMAX) return -FIXEDMAX;
+    return (int32_t)value;
+}
+
+double FixedPID::_toDouble(const int32_t& value){
+    return value * (1.0 / FIXEDONE);
+}
+
+int32_t FixedPID::_add(const int32_t& a, const int32_t& b){
+    /*
+    Adds two 16.16 numbers, saturating if the sum doesn't fit
+    */
+    int32_t sum = (int32_t)((uint32_t)a + (uint32_t)b);
+    if(((a ^ sum) & (b ^ sum)) < 0){
+        return (a < 0) ? -FIXEDMAX : FIXEDMAX;
+    }
+    return sum;
+}
+
+int32_t FixedPID::_subtract(const int32_t& a, const int32_t& b){
+    /*
+    Subtracts one 16.16 number from another, saturating if the difference doesn't fit
+    */
+    int32_t difference = (int32_t)((uint32_t)a - (uint32_t)b);
+    if(((a ^ b) & (a ^ difference)) < 0){
+        return (a < 0) ? -FIXEDMAX : FIXEDMAX;
+    }
+    return difference;
+}
+
+int32_t FixedPID::_multiply(const int32_t& a, const int32_t& b){
+    /*
+    Multiplies two 16.16 numbers, saturating if the result doesn't fit.  The
+    numbers are split into their whole and fractional halves so that it only
+    takes four 16 x 16 bit products, which the Mega's multiply instruction does
+    in a few steps, instead of a 64 bit multiply done in software.
+    */
+    int16_t  aWhole = a >> 16;
+    int16_t  bWhole = b >> 16;
+    uint16_t aFraction = a & 0xFFFF;
+    uint16_t bFraction = b & 0xFFFF;
+
+    int32_t whole = (int32_t)aWhole * bWhole;
+    if(whole > 32767 || whole < -32768){
+        return (whole < 0) ? -FIXEDMAX : FIXEDMAX;
+    }
+    int32_t result = _add(whole * FIXEDONE, (int32_t)aWhole * bFraction);
+    result = _add(result, (int32_t)bWhole * aFraction);
+    return _add(result, ((uint32_t)aFraction * bFraction) >> 16);
+}
+
+int32_t FixedPID::_clamp(const int32_t& value){
+    if(value > outMax) return outMax;
+    if(value < outMin) return outMin;
+    return value;
+}
+
+void SelectablePID::useFixedPoint(const bool& fixed){
+    _fixed = fixed;
+}
+
+void SelectablePID::setup(volatile double* Input, volatile double* Output, volatile double* Setpoint,
+        float* Kp, float* Ki, float* Kd, float* POn, const int& ControllerDirection)
+{
+    if(_fixed) _fixedPoint.setup(Input, Output, Setpoint, Kp, Ki, Kd, POn, ControllerDirection);
+    else       _floating.setup(Input, Output, Setpoint, Kp, Ki, Kd, POn, ControllerDirection);
+}
+
+void SelectablePID::SetMode(const int& Mode){
+    if(_fixed) _fixedPoint.SetMode(Mode);
+    else       _floating.SetMode(Mode);
+}
+
+bool SelectablePID::Compute(){
+    return _fixed ? _fixedPoint.Compute() : _floating.Compute();
+}
+
+void SelectablePID::SetOutputLimits(const double& Min, const double& Max){
+    if(_fixed) _fixedPoint.SetOutputLimits(Min, Max);
+    else       _floating.SetOutputLimits(Min, Max);
+}
+
+void SelectablePID::SetTunings(float* Kp, float* Ki, float* Kd, float* POn){
+    if(_fixed) _fixedPoint.SetTunings(Kp, Ki, Kd, POn);
+    else       _floating.SetTunings(Kp, Ki, Kd, POn);
+}
+
+void SelectablePID::SetSampleTime(const int& NewSampleTime){
+    if(_fixed) _fixedPoint.SetSampleTime(NewSampleTime);
+    else       _floating.SetSampleTime(NewSampleTime);
+}
+
+String SelectablePID::pidState(){
+    return _fixed ? _fixedPoint.pidState() : _floating.pidState();
+}
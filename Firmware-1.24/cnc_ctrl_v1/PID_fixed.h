@@ -0,0 +1,105 @@
+/*This file is part of the Maslow Control Software.
+    The Maslow Control Software is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    Maslow Control Software is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with the Maslow Control Software.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2014-2017 Bar Smith*/
+
+// A drop in replacement for the PID class in PID_v1 which does its sums in
+// 16.16 fixed point.  The input and setpoint are converted once as they are
+// read and the output once as it is written, everything in between is
+// integer.  Chosen in place of PID for each axis by FIXEDPOSITIONPID and
+// FIXEDVELOCITYPID in Config.h, through SelectablePID.
+//
+// Only 32 bit arithmetic is used, no 64 bit products, so that it is cheaper
+// than floating point on the Mega.  Values and tunings after being scaled by
+// the sample time are bounded to +/-32767 and saturate there rather than
+// wrapping, and tunings smaller than 1/65536 are lost.  That is plenty for the
+// chain positions in rotations, the speeds in RPM and the gains used by Maslow.
+
+#ifndef PID_fixed_h
+#define PID_fixed_h
+
+class FixedPID
+{
+  public:
+    FixedPID();
+
+    void setup(volatile double*, volatile double*, volatile double*,
+        float*, float*, float*, float*, const int&);
+    void SetMode(const int& Mode);
+    bool Compute();
+    void SetOutputLimits(const double&, const double&);
+    void SetTunings(float*, float*, float*, float*);
+    void SetControllerDirection(const int&);
+    void SetSampleTime(const int&);
+
+    double GetKp();
+    double GetKi();
+    double GetKd();
+    int GetMode();
+    int GetDirection();
+    double GetIterm();
+    String pidState();
+
+  private:
+    void Initialize();
+    static int32_t _toFixed(double value);
+    static double  _toDouble(const int32_t& value);
+    static int32_t _add(const int32_t& a, const int32_t& b);
+    static int32_t _subtract(const int32_t& a, const int32_t& b);
+    static int32_t _multiply(const int32_t& a, const int32_t& b);
+    int32_t        _clamp(const int32_t& value);
+
+    float *dispKp;              // tunings as entered, for display
+    float *dispKi;
+    float *dispKd;
+
+    int32_t kp;                 // tunings scaled by the sample time and signed
+    int32_t ki;                 // by the direction, in 16.16
+    int32_t kd;
+    int32_t pOnEKp, pOnMKp;
+    bool    pOnE, pOnM;
+
+    int controllerDirection;
+
+    volatile double *myInput;
+    volatile double *myOutput;
+    volatile double *mySetpoint;
+
+    int32_t outputSum, lastInput;   // in 16.16
+
+    unsigned long SampleTime;   // in milliseconds
+    int32_t outMin, outMax;     // in 16.16
+    bool inAuto;
+};
+
+// Runs either a PID or a FixedPID, so that the fixed point controller can be
+// used for some axes and not others.  useFixedPoint() chooses which, before
+// setup().  Only used when FIXEDPOSITIONPID or FIXEDVELOCITYPID choose an axis.
+class SelectablePID
+{
+  public:
+    void useFixedPoint(const bool& fixed);
+    void setup(volatile double*, volatile double*, volatile double*,
+        float*, float*, float*, float*, const int&);
+    void SetMode(const int& Mode);
+    bool Compute();
+    void SetOutputLimits(const double&, const double&);
+    void SetTunings(float*, float*, float*, float*);
+    void SetSampleTime(const int&);
+    String pidState();
+
+  private:
+    bool     _fixed = false;
+    PID      _floating;
+    FixedPID _fixedPoint;
+};
+#endif
@@ -0,0 +1,212 @@
+/*This file is part of the Maslow Control Software.
+    The Maslow Control Software is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    Maslow Control Software is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with the Maslow Control Software.  If not, see <http://www.gnu.org/licenses/>.
+    
+    Copyright 2014-2017 Bar Smith*/
+
+/*
+The planner holds the next few straight moves so that the machine does not have to
+come to a stop at the end of every line of gcode.  Each time a move is added, the
+speed the machine can carry through every corner is worked out from the angle of the
+corner and the acceleration of the machine, so that it can always slow down in time
+for the end of the last move in the queue.  This is based on the planner in GRBL,
+https://github.com/gnea/grbl
+
+The moves are run by executePlannedMoves() in Motion.cpp
+*/
+
+#include "Maslow.h"
+
+planBlock_t   plannerBuffer[PLANNERBUFFERSIZE];
+byte          plannerTail = 0;    // Move being run
+byte          plannerHead = 0;    // Where the next move will be added
+byte          plannerCount = 0;   // Number of moves in the buffer
+float         plannerZPosition = 0;   // Z at the end of everything planned or queued so far
+
+byte  _plannerNextIndex(const byte& index){
+    return (index + 1 == PLANNERBUFFERSIZE) ? 0 : index + 1;
+}
+
+byte  _plannerPrevIndex(const byte& index){
+    return (index == 0) ? PLANNERBUFFERSIZE - 1 : index - 1;
+}
+
+void  plannerReset(){
+    // Called on startup or after a stop command, the machine has stopped so z is
+    // where the encoder says it is
+    plannerTail  = 0;
+    plannerHead  = 0;
+    plannerCount = 0;
+    plannerZPosition = zAxis.read();
+}
+
+bool  plannerIsEmpty(){
+    return plannerCount == 0;
+}
+
+bool  plannerIsFull(){
+    return plannerCount == PLANNERBUFFERSIZE;
+}
+
+void  plannerGetPosition(float* xPos, float* yPos, float* zPos){
+    /*
+    Returns the position the machine will be at once every move in the planner has
+    been run.  New moves start from here.  This is where the machine has been told
+    to go, not where the encoders are, because the setpoints sent to the axes may
+    still be catching up.
+    */
+    if (plannerIsEmpty()){
+        *xPos = sys.xPosition;
+        *yPos = sys.yPosition;
+        *zPos = plannerZPosition;
+    }
+    else{
+        planBlock_t* block = &plannerBuffer[_plannerPrevIndex(plannerHead)];
+        *xPos = block->xEnd;
+        *yPos = block->yEnd;
+        *zPos = block->zEnd;
+    }
+}
+
+void  plannerSetZPosition(const float& zPos){
+    /*
+    Tells the planner where z will be after a move which didn't go through it, or
+    after z has been set to a new value
+    */
+    plannerZPosition = zPos;
+}
+
+void  _plannerRecalculate(){
+    /*
+    Works out the entry speed of every move in the buffer.  The reverse pass limits each
+    move to a speed it can slow down from in time for the next move, with the last move in
+    the buffer ending at rest.  The forward pass then limits each move to a speed it can
+    reach from the move before it.  The move being run is never changed, the machine is
+    already moving at its entry speed.
+    */
+    byte  index = _plannerPrevIndex(plannerHead);
+    float nextEntrySpeedSqr = 0;
+    while (index != plannerTail){
+        planBlock_t* block = &plannerBuffer[index];
+        block->entrySpeedSqr = min(block->maxEntrySpeedSqr, nextEntrySpeedSqr + 2 * PLANNERACCELERATION * block->millimeters);
+        nextEntrySpeedSqr = block->entrySpeedSqr;
+        index = _plannerPrevIndex(index);
+    }
+
+    index = plannerTail;
+    byte next = _plannerNextIndex(index);
+    while (next != plannerHead){
+        planBlock_t* block     = &plannerBuffer[index];
+        planBlock_t* nextBlock = &plannerBuffer[next];
+        nextBlock->entrySpeedSqr = min(nextBlock->entrySpeedSqr, block->entrySpeedSqr + 2 * PLANNERACCELERATION * block->millimeters);
+        index = next;
+        next  = _plannerNextIndex(next);
+    }
+}
+
+void  plannerBufferLine(const float& xEnd, const float& yEnd, const float& zEnd, const float& MMPerMin){
+    /*
+    Adds a straight move from the end of the last move in the planner to (xEnd, yEnd, zEnd)
+    at MMPerMin.  The caller must make sure the planner is not full.
+    */
+
+    float xStart, yStart, zStart;
+    plannerGetPosition(&xStart, &yStart, &zStart);
+
+    float xDistanceToMoveInMM = xEnd - xStart;
+    float yDistanceToMoveInMM = yEnd - yStart;
+    float zDistanceToMoveInMM = zEnd - zStart;
+    float distanceToMoveInMM  = sqrt(sq(xDistanceToMoveInMM) + sq(yDistanceToMoveInMM) + sq(zDistanceToMoveInMM));
+
+    if (distanceToMoveInMM < 0.0001){
+        return;   // Nothing to do
+    }
+
+    planBlock_t* block  = &plannerBuffer[plannerHead];
+    block->xEnd         = xEnd;
+    block->yEnd         = yEnd;
+    block->zEnd         = zEnd;
+    block->xUnit        = xDistanceToMoveInMM/distanceToMoveInMM;
+    block->yUnit        = yDistanceToMoveInMM/distanceToMoveInMM;
+    block->zUnit        = zDistanceToMoveInMM/distanceToMoveInMM;
+    block->millimeters  = distanceToMoveInMM;
+    plannerZPosition    = zEnd;
+
+    //throttle back feedrate if it exceeds zaxis max
+    float  zMaxFeed     = sysSettings.maxZRPM * abs(zAxis.getPitch());
+    float  feedrate     = constrain(MMPerMin, 1, sysSettings.maxFeed);
+    if (feedrate * fabs(block->zUnit) > zMaxFeed){
+        feedrate = zMaxFeed / fabs(block->zUnit);
+    }
+    block->nominalSpeed = feedrate / 60.0;
+
+    if (plannerIsEmpty()){
+        // The machine is at rest
+        block->maxEntrySpeedSqr = 0;
+    }
+    else{
+        /*
+        The speed through the corner with the previous move is the speed at which the
+        acceleration needed to go around a circle which deviates from the corner by
+        PLANNERJUNCTIONDEVIATION equals PLANNERACCELERATION
+        */
+        planBlock_t* prevBlock  = &plannerBuffer[_plannerPrevIndex(plannerHead)];
+        float cosTheta          = -(prevBlock->xUnit * block->xUnit + prevBlock->yUnit * block->yUnit + prevBlock->zUnit * block->zUnit);
+        float maxJunctionSpeedSqr;
+        if (cosTheta > 0.999999){
+            // The machine is reversing direction
+            maxJunctionSpeedSqr = 0;
+        }
+        else{
+            cosTheta = max(cosTheta, -0.999999);
+            float sinThetaD2 = sqrt(0.5 * (1.0 - cosTheta));
+            maxJunctionSpeedSqr = (PLANNERACCELERATION * PLANNERJUNCTIONDEVIATION * sinThetaD2) / (1.0 - sinThetaD2);
+        }
+        block->maxEntrySpeedSqr = min(maxJunctionSpeedSqr, min(sq(block->nominalSpeed), sq(prevBlock->nominalSpeed)));
+    }
+    block->entrySpeedSqr = 0;
+
+    plannerHead = _plannerNextIndex(plannerHead);
+    plannerCount++;
+
+    _plannerRecalculate();
+}
+
+planBlock_t* plannerGetCurrentBlock(){
+    /*
+    Returns the move being run, or NULL if there is nothing to do
+    */
+    if (plannerIsEmpty()){
+        return NULL;
+    }
+    return &plannerBuffer[plannerTail];
+}
+
+float plannerGetExitSpeedSqr(){
+    /*
+    Returns the speed the current move should end at, which is the entry speed of the
+    move after it, or zero if it is the last one
+    */
+    if (plannerCount < 2){
+        return 0;
+    }
+    return plannerBuffer[_plannerNextIndex(plannerTail)].entrySpeedSqr;
+}
+
+void  plannerDiscardCurrentBlock(){
+    /*
+    Removes the move being run once it is finished
+    */
+    if (!plannerIsEmpty()){
+        plannerTail = _plannerNextIndex(plannerTail);
+        plannerCount--;
+    }
+}
@@ -0,0 +1,45 @@
+/*This file is part of the Maslow Control Software.
+    The Maslow Control Software is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    Maslow Control Software is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with the Maslow Control Software.  If not, see <http://www.gnu.org/licenses/>.
+    
+    Copyright 2014-2017 Bar Smith*/
+
+// This contains the look-ahead motion planner
+
+#ifndef planner_h
+#define planner_h
+
+// A straight move waiting in the planner.  The start of each move is the end
+// of the one before it.
+typedef struct {
+  float xEnd;                 // Target position in mm
+  float yEnd;
+  float zEnd;
+  float xUnit;                // Direction of travel
+  float yUnit;
+  float zUnit;
+  float millimeters;          // Length of the move
+  float nominalSpeed;         // Speed to cruise at in mm/s, after the z-axis limit
+  float maxEntrySpeedSqr;     // Fastest the move can be entered in (mm/s)^2, set by the corner with the previous move
+  float entrySpeedSqr;        // Planned entry speed in (mm/s)^2
+} planBlock_t;
+
+void  plannerReset();
+bool  plannerIsEmpty();
+bool  plannerIsFull();
+void  plannerGetPosition(float*, float*, float*);
+void  plannerSetZPosition(const float&);
+void  plannerBufferLine(const float&, const float&, const float&, const float&);
+planBlock_t* plannerGetCurrentBlock();
+float plannerGetExitSpeedSqr();
+void  plannerDiscardCurrentBlock();
+
+#endif
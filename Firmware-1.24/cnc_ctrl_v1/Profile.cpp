@@ -0,0 +1,101 @@
+/*This file is part of the Maslow Control Software.
+    The Maslow Control Software is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    Maslow Control Software is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with the Maslow Control Software.  If not, see <http://www.gnu.org/licenses/>.
+    
+    Copyright 2014-2017 Bar Smith*/
+
+/*
+Keeps the shortest, average and longest time taken by each part of the control loop
+so that it can be seen where the LOOPINTERVAL goes.  The parts which are timed are
+listed in Profile.h, and the times are sent and cleared by the $P command.
+*/
+
+#include "Maslow.h"
+
+#if PROFILING > 0
+
+typedef struct {
+  unsigned long count;        // Number of times the section has run
+  unsigned long total;        // Total time in us, for the average
+  unsigned long shortest;     // in us
+  unsigned long longest;      // in us
+} profileSection_t;
+
+profileSection_t profileSections[PROFILE_SECTIONS];
+unsigned long    profileOverruns = 0;   // Number of times the PID loop ran before there was a new setpoint
+
+void  profileRecord(byte section, unsigned long startTime){
+    /*
+    Adds the time since startTime to a section
+    */
+    unsigned long duration = micros() - startTime;
+    profileSection_t* timing = &profileSections[section];
+    if (timing->count == 0 || duration < timing->shortest){
+        timing->shortest = duration;
+    }
+    if (duration > timing->longest){
+        timing->longest = duration;
+    }
+    timing->total += duration;
+    timing->count++;
+}
+
+void  profileOverrun(){
+    /*
+    Called by the PID loop when a move is running and it has not been given a new setpoint
+    since the last time it ran
+    */
+    profileOverruns++;
+}
+
+void  reportProfile(){
+    /*
+    Sends the timing of each section and the number of overruns since the last report,
+    then starts over
+    */
+    static const char* const names[PROFILE_SECTIONS] = {"timer", "left PID", "right PID", "z PID", "inverse", "planner", "realtime", "gcode", "velocity PID"};
+    profileSection_t timing;
+    
+    for (byte section = 0; section < PROFILE_SECTIONS; section++){
+        //the timer and PID sections are written to by the timer interrupt
+        noInterrupts();
+        timing = profileSections[section];
+        profileSections[section].count = 0;
+        profileSections[section].total = 0;
+        profileSections[section].longest = 0;
+        interrupts();
+        
+        Serial.print(names[section]);
+        Serial.print(F(": "));
+        Serial.print(timing.count);
+        if (timing.count > 0){
+            Serial.print(F(" runs, min "));
+            Serial.print(timing.shortest);
+            Serial.print(F("us, avg "));
+            Serial.print(timing.total / timing.count);
+            Serial.print(F("us, max "));
+            Serial.print(timing.longest);
+            Serial.println(F("us"));
+        }
+        else{
+            Serial.println(F(" runs"));
+        }
+    }
+    
+    noInterrupts();
+    unsigned long overruns = profileOverruns;
+    profileOverruns = 0;
+    interrupts();
+    Serial.print(F("overruns: "));
+    Serial.println(overruns);
+}
+
+#endif
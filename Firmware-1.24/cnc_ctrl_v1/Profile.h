@@ -0,0 +1,47 @@
+/*This file is part of the Maslow Control Software.
+    The Maslow Control Software is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    Maslow Control Software is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with the Maslow Control Software.  If not, see <http://www.gnu.org/licenses/>.
+    
+    Copyright 2014-2017 Bar Smith*/
+
+// This contains the timing of the control loop, only used if PROFILING is set
+// in Config.h
+
+#ifndef profile_h
+#define profile_h
+
+// The parts of the Firmware which are timed
+#define PROFILE_TIMER      0   // runsOnATimer()
+#define PROFILE_LEFTPID    1   // leftAxis.computePID()
+#define PROFILE_RIGHTPID   2   // rightAxis.computePID()
+#define PROFILE_ZPID       3   // zAxis.computePID()
+#define PROFILE_INVERSE    4   // kinematics.inverse()
+#define PROFILE_PLANNER    5   // executePlannedMoves()
+#define PROFILE_REALTIME   6   // execSystemRealtime()
+#define PROFILE_GCODE      7   // gcodeExecuteLoop()
+#define PROFILE_VELOCITYPID 8  // computeVelocityPID() of all three axes
+#define PROFILE_SECTIONS   9
+
+#if PROFILING > 0
+  // Time the code between PROFILESTART(section) and PROFILEEND(section), which
+  // must be in the same scope
+  #define PROFILESTART(section) unsigned long profileStart##section = micros()
+  #define PROFILEEND(section)   profileRecord(section, profileStart##section)
+
+  void  profileRecord(byte, unsigned long);
+  void  profileOverrun();
+  void  reportProfile();
+#else
+  #define PROFILESTART(section)
+  #define PROFILEEND(section)
+#endif
+
+#endif
@@ -27,10 +27,19 @@ void  reportStatusMessage(byte status_code){
     to indicate some error event with the line or some critical system error during
     operation.
     
+    In streaming mode (turned on by $S=1) the 'ok' is followed by the space left in
+    the incoming buffer, eg "ok:212", so that the host can send the next lines without
+    waiting for the ones ahead of them to finish.
+    
     Taken from Grbl http://github.com/grbl/grbl
     */
     if (status_code == 0) { // STATUS_OK
-      Serial.println(F("ok"));
+      if (sys.streaming) {
+        Serial.print(F("ok:"));
+        Serial.println(incSerialBuffer.spaceAvailable());
+      } else {
+        Serial.println(F("ok"));
+      }
     } else {
       Serial.print(F("error: "));
       #ifdef REPORT_GUI_MODE
@@ -44,8 +53,8 @@ void  reportStatusMessage(byte status_code){
             Serial.println(F("Invalid statement")); break;
           case STATUS_OLD_SETTINGS:
             Serial.println(F("Please set $12, $13, $19, and $20 to load old position data.")); break;
-          // case STATUS_NEGATIVE_VALUE:
-          // Serial.println(F("Value < 0")); break;
+          case STATUS_NEGATIVE_VALUE:
+            Serial.println(F("Value < 0")); break;
           // case STATUS_SETTING_DISABLED:
           // Serial.println(F("Setting disabled")); break;
           // case STATUS_SETTING_STEP_PULSE_MIN:
@@ -139,96 +148,39 @@ void  reportAlarmMessage(byte alarm_code) {
 void reportMaslowSettings() {
   // Print Maslow settings.
   // Taken from Grbl. http://github.com/grbl/grbl
-  #ifdef REPORT_GUI_MODE
-    Serial.print(F("$0=")); Serial.println(sysSettings.machineWidth, 8);
-    Serial.print(F("$1=")); Serial.println(sysSettings.machineHeight, 8);
-    Serial.print(F("$2=")); Serial.println(sysSettings.distBetweenMotors, 8);
-    Serial.print(F("$3=")); Serial.println(sysSettings.motorOffsetY, 8);
-    Serial.print(F("$4=")); Serial.println(sysSettings.sledWidth, 8);
-    Serial.print(F("$5=")); Serial.println(sysSettings.sledHeight, 8);
-    Serial.print(F("$6=")); Serial.println(sysSettings.sledCG, 8);
-    Serial.print(F("$7=")); Serial.println(sysSettings.kinematicsType);
-    Serial.print(F("$8=")); Serial.println(sysSettings.rotationDiskRadius, 8);
-    Serial.print(F("$9=")); Serial.println(sysSettings.axisDetachTime);
-    Serial.print(F("$10=")); Serial.println(sysSettings.chainLength);
-    Serial.print(F("$11=")); Serial.println(sysSettings.originalChainLength);
-    Serial.print(F("$12=")); Serial.println(sysSettings.encoderSteps, 8);
-    Serial.print(F("$13=")); Serial.println(sysSettings.distPerRot, 8);
-    Serial.print(F("$15=")); Serial.println(sysSettings.maxFeed);
-    Serial.print(F("$16=")); Serial.println(sysSettings.zAxisAttached);
-    Serial.print(F("$17=")); Serial.println(sysSettings.spindleAutomate);
-    Serial.print(F("$18=")); Serial.println(sysSettings.maxZRPM, 8);
-    Serial.print(F("$19=")); Serial.println(sysSettings.zDistPerRot, 8);
-    Serial.print(F("$20=")); Serial.println(sysSettings.zEncoderSteps, 8);
-    Serial.print(F("$21=")); Serial.println(sysSettings.KpPos, 8);
-    Serial.print(F("$22=")); Serial.println(sysSettings.KiPos, 8);
-    Serial.print(F("$23=")); Serial.println(sysSettings.KdPos, 8);
-    Serial.print(F("$24=")); Serial.println(sysSettings.propWeightPos, 8);
-    Serial.print(F("$25=")); Serial.println(sysSettings.KpV, 8);
-    Serial.print(F("$26=")); Serial.println(sysSettings.KiV, 8);
-    Serial.print(F("$27=")); Serial.println(sysSettings.KdV, 8);
-    Serial.print(F("$28=")); Serial.println(sysSettings.propWeightV, 8);
-    Serial.print(F("$29=")); Serial.println(sysSettings.zKpPos, 8);
-    Serial.print(F("$30=")); Serial.println(sysSettings.zKiPos, 8);
-    Serial.print(F("$31=")); Serial.println(sysSettings.zKdPos, 8);
-    Serial.print(F("$32=")); Serial.println(sysSettings.zPropWeightPos, 8);
-    Serial.print(F("$33=")); Serial.println(sysSettings.zKpV, 8);
-    Serial.print(F("$34=")); Serial.println(sysSettings.zKiV, 8);
-    Serial.print(F("$35=")); Serial.println(sysSettings.zKdV, 8);
-    Serial.print(F("$36=")); Serial.println(sysSettings.zPropWeightV, 8);
-    Serial.print(F("$37=")); Serial.println(sysSettings.chainSagCorrection, 8);
-    Serial.print(F("$38=")); Serial.println(sysSettings.chainOverSprocket);
-    Serial.print(F("$39=")); Serial.println(sysSettings.fPWM);
-    Serial.print(F("$40=")); Serial.println(sysSettings.leftChainTolerance, 8);
-    Serial.print(F("$41=")); Serial.println(sysSettings.rightChainTolerance, 8);
-    Serial.print(F("$42=")); Serial.println(sysSettings.positionErrorLimit, 8);
-    
-  #else
-    Serial.print(F("$0=")); Serial.print(sysSettings.machineWidth);
-    Serial.print(F(" (machine width, mm)\r\n$1=")); Serial.print(sysSettings.machineHeight, 8);
-    Serial.print(F(" (machine height, mm)\r\n$2=")); Serial.print(sysSettings.distBetweenMotors, 8);
-    Serial.print(F(" (motor distance, mm)\r\n$3=")); Serial.print(sysSettings.motorOffsetY, 8);
-    Serial.print(F(" (motor height, mm)\r\n$4=")); Serial.print(sysSettings.sledWidth, 8);
-    Serial.print(F(" (sled width, mm)\r\n$5=")); Serial.print(sysSettings.sledHeight, 8);
-    Serial.print(F(" (sled height, mm)\r\n$6=")); Serial.print(sysSettings.sledCG, 8);
-    Serial.print(F(" (sled cg, mm)\r\n$7=")); Serial.print(sysSettings.kinematicsType);
-    Serial.print(F(" (Kinematics Type 1=Quadrilateral, 2=Triangular)\r\n$8=")); Serial.print(sysSettings.rotationDiskRadius, 8);
-    Serial.print(F(" (rotation radius, mm)\r\n$9=")); Serial.print(sysSettings.axisDetachTime);
-    Serial.print(F(" (axis idle before detach, ms)\r\n$10=")); Serial.print(sysSettings.chainLength);
-    Serial.print(F(" (full length of chain, mm)\r\n$11=")); Serial.print(sysSettings.originalChainLength);
-    Serial.print(F(" (calibration chain length, mm)\r\n$12=")); Serial.print(sysSettings.encoderSteps, 8);
-    Serial.print(F(" (main steps per revolution)\r\n$13=")); Serial.print(sysSettings.distPerRot, 8);
-    Serial.print(F(" (distance / rotation, mm)\r\n$15=")); Serial.print(sysSettings.maxFeed);
-    Serial.print(F(" (max feed, mm/min)\r\n$16=")); Serial.print(sysSettings.zAxisAttached);
-    Serial.print(F(" (Auto Z Axis, 1 = Yes)\r\n$17=")); Serial.print(sysSettings.spindleAutomateType);
-    Serial.print(F(" (auto spindle enable 1=servo, 2=relay_h, 3=relay_l)\r\n$18=")); Serial.print(sysSettings.maxZRPM, 8);
-    Serial.print(F(" (max z axis RPM)\r\n$19=")); Serial.print(sysSettings.zDistPerRot, 8);
-    Serial.print(F(" (z axis distance / rotation)\r\n$20=")); Serial.print(sysSettings.zEncoderSteps, 8);
-    Serial.print(F(" (z axis steps per revolution)\r\n$21=")); Serial.print(sysSettings.KpPos, 8);
-    Serial.print(F(" (main Kp Pos)\r\n$22=")); Serial.print(sysSettings.KiPos, 8);
-    Serial.print(F(" (main Ki Pos)\r\n$23=")); Serial.print(sysSettings.KdPos, 8);
-    Serial.print(F(" (main Kd Pos)\r\n$24=")); Serial.print(sysSettings.propWeightPos, 8);
-    Serial.print(F(" (main Pos proportional weight)\r\n$25=")); Serial.print(sysSettings.KpV, 8);
-    Serial.print(F(" (main Kp Velocity)\r\n$26=")); Serial.print(sysSettings.KiV, 8);
-    Serial.print(F(" (main Ki Velocity)\r\n$27=")); Serial.print(sysSettings.KdV, 8);
-    Serial.print(F(" (main Kd Velocity)\r\n$28=")); Serial.print(sysSettings.propWeightV, 8);
-    Serial.print(F(" (main Velocity proportional weight)\r\n$29=")); Serial.print(sysSettings.zKpPos, 8);
-    Serial.print(F(" (z axis Kp Pos)\r\n$30=")); Serial.print(sysSettings.zKiPos, 8);
-    Serial.print(F(" (z axis Ki Pos)\r\n$31=")); Serial.print(sysSettings.zKdPos, 8);
-    Serial.print(F(" (z axis Kd Pos)\r\n$32=")); Serial.print(sysSettings.zPropWeightPos, 8);
-    Serial.print(F(" (z axis Pos proportional weight)\r\n$33=")); Serial.print(sysSettings.zKpV, 8);
-    Serial.print(F(" (z axis Kp Velocity)\r\n$34=")); Serial.print(sysSettings.zKiV, 8);
-    Serial.print(F(" (z axis Ki Velocity)\r\n$35=")); Serial.print(sysSettings.zKdV, 8);
-    Serial.print(F(" (z axis Kd Velocity)\r\n$36=")); Serial.print(sysSettings.zPropWeightV, 8);
-    Serial.print(F(" (z axis Velocity proportional weight)\r\n$37=")); Serial.print(sysSettings.chainSagCorrection, 8);
-    Serial.print(F(" (chain sag correction value)\r\n$38=")); Serial.print(sysSettings.chainOverSprocket);
-    Serial.print(F(" (chain over sprocket)\r\n$39=")); Serial.print(sysSettings.fPWM);
-    Serial.print(F(" (PWM frequency value 1=39,000Hz, 2=4,100Hz, 3=490Hz)\r\n$40=")); Serial.print(sysSettings.leftChainTolerance, 8);
-    Serial.print(F(" (chain tolerance, left chain, mm)\r\n$41=")); Serial.print(sysSettings.rightChainTolerance, 8);
-    Serial.print(F(" (chain tolerance, right chain, mm)\r\n$42=")); Serial.print(sysSettings.positionErrorLimit, 8);
-    Serial.print(F(" (position error alarm limit, mm)"));
+  settingDescriptor_t setting;
+  PGM_P name = settingsNames;
+  for (byte i = 0; i < SETTINGSCOUNT; i++){
+    memcpy_P(&setting, &settingsTable[i], sizeof(setting));
+    Serial.print('$');
+    Serial.print(setting.id);
+    Serial.print('=');
+    if (setting.type == SETTING_FLOAT){
+      Serial.print(settingsGetValue(setting), 8);
+    }
+    else {
+      Serial.print((unsigned int)settingsGetValue(setting));
+    }
+    #ifndef REPORT_GUI_MODE
+      Serial.print(F(" ("));
+      Serial.print((const __FlashStringHelper*)name);
+      Serial.print(')');
+    #endif
     Serial.println();
-  #endif
+    name += strlen_P(name) + 1;
+  }
+}
+
+void  reportBufferSize(){
+    /*
+    Sends the space left in the incoming buffer and the size of the buffer, a host which
+    keeps count of the characters it has sent can use this to keep the buffer full
+    */
+    Serial.print(F("[BF:"));
+    Serial.print(incSerialBuffer.spaceAvailable());
+    Serial.print(',');
+    Serial.print(INCBUFFERLENGTH - 1);
+    Serial.println(F("]"));
 }
 
 void  returnError(){
@@ -243,6 +195,14 @@ void  returnError(){
         Serial.print(',');
         Serial.print(incSerialBuffer.spaceAvailable());
         Serial.println(F("]"));
+        checkPositionError();
+}
+
+void  checkPositionError(){
+    /*
+    Raises an alarm if either chain is further from where it should be than the
+    position error limit
+    */
         if (!sys.stop) {
           if (!(sys.state & STATE_POS_ERR_IGNORE)) {
             if ((abs(leftAxis.error()) >= sysSettings.positionErrorLimit) || (abs(rightAxis.error()) >= sysSettings.positionErrorLimit)) {
@@ -252,15 +212,74 @@ void  returnError(){
         }
 }
 
+static byte _reportHex(unsigned long value, byte digits){
+    /*
+    Prints the lowest digits hex digits of value, with leading zeros.  Returns the sum of
+    the bytes printed for the status frame checksum.
+    */
+    static const char hexDigits[] = "0123456789ABCDEF";
+    byte sum = 0;
+    while (digits > 0){
+        digits--;
+        char digit = hexDigits[(value >> (4*digits)) & 0xF];
+        Serial.write(digit);
+        sum += digit;
+    }
+    return sum;
+}
+
+void  reportStatusFrame(){
+    /*
+    Sends the machine status as a fixed width frame of hex digits, which is much quicker
+    to produce than the text position and error reports because no floats are printed.
+    The frame is:
+    
+        {XXXXXXXXYYYYYYYYZZZZZZZZLLLLRRRRBBBBSSPPCC}
+    
+    X, Y and Z are the position in thousandths of a mm and L and R are the left and right
+    chain errors in thousandths of a mm, all two's complement.  The errors are limited to
+    +/-32.767mm.  B is the space in the incoming buffer, S is sys.state, P is bit 0 for
+    stop and bit 1 for pause, and C is the sum of the bytes of the other digits.
+    */
+    long leftError  = constrain(leftAxis.error()*1000,  -32767, 32767);
+    long rightError = constrain(rightAxis.error()*1000, -32767, 32767);
+    byte flags      = (sys.stop ? bit(0) : 0) | (sys.pause ? bit(1) : 0);
+    byte sum        = 0;
+    
+    Serial.write('{');
+    sum += _reportHex(long(sys.xPosition*1000), 8);
+    sum += _reportHex(long(sys.yPosition*1000), 8);
+    sum += _reportHex(long(zAxis.read()*1000), 8);
+    sum += _reportHex(leftError, 4);
+    sum += _reportHex(rightError, 4);
+    sum += _reportHex(incSerialBuffer.spaceAvailable(), 4);
+    sum += _reportHex(sys.state, 2);
+    sum += _reportHex(flags, 2);
+    _reportHex(sum, 2);
+    Serial.println('}');
+}
+
 void  returnPoz(){
     /*
     Causes the machine's position (x,y) to be sent over the serial connection updated on the UI
     in Ground Control. Also causes the error report to be sent. Only executes 
     if hasn't been called in at least POSITIONTIMEOUT ms.
+    
+    If status frames have been turned on with $F the status frame is sent instead, every
+    sys.statusFrameInterval ms.
     */
     
     static unsigned long lastRan = millis();
     
+    if (sys.statusFrameInterval > 0){
+        if (millis() - lastRan >= sys.statusFrameInterval){
+            reportStatusFrame();
+            checkPositionError();
+            lastRan = millis();
+        }
+        return;
+    }
+    
     if (millis() - lastRan > POSITIONTIMEOUT){
         
         
@@ -304,6 +323,11 @@ void  reportMaslowHelp(){
         // Serial.println(F("$I (view build info)"));
         // Serial.println(F("$N (view startup blocks)"));
         Serial.println(F("$x=value (save Maslow setting)"));
+        Serial.println(F("$S (view buffer space), $S=1 or $S=0 (streaming mode on or off)"));
+        Serial.println(F("$F=ms (hex status frame every ms milliseconds, 0 for text reports)"));
+        #if PROFILING > 0
+        Serial.println(F("$P (view control loop timing)"));
+        #endif
         // Serial.println(F("$Nx=line (save startup block)"));
         // Serial.println(F("$C (check gcode mode)"));
         // Serial.println(F("$X (kill alarm lock)"));
@@ -78,7 +78,10 @@ void  reportStatusMessage(byte);
 void  reportFeedbackMessage(byte);
 void  reportMaslowSettings();
 void  reportAlarmMessage(byte);
+void  reportBufferSize();
 void  returnError();
+void  checkPositionError();
+void  reportStatusFrame();
 void  returnPoz();
 void  reportMaslowHelp();
 
@@ -36,6 +36,9 @@ int RingBuffer::write(char letter){
     if (letter != '?'){                    //ignore question marks because grbl sends them all the time
         _buffer[_endOfString] = letter;
         int bufferOverflow = _incrementEnd();
+        if (letter == '\n' && bufferOverflow == 0){
+            _lineCount++;
+        }
         return bufferOverflow;
     }
     return 0;
@@ -56,6 +59,9 @@ char RingBuffer::read(){
         letter = _buffer[_beginningOfString];     //else return first character
         _buffer[_beginningOfString] = '\0';       //set the read character to null so it cannot be read again
         _incrementBeginning();                    //and increment the pointer
+        if (letter == '\n'){
+            _lineCount--;
+        }
     }
 
     return letter;
@@ -64,51 +70,122 @@ char RingBuffer::read(){
 int RingBuffer::numberOfLines() {
     /*
 
-    Return the number of full lines (as determined by \n terminations) in the buffer
+    Return the number of full lines (as determined by \n terminations) in the buffer,
+    which is counted as characters are written and read
 
     */
 
-    int lineCount = 0;
+    return _lineCount;
+}
 
-    int  i = _beginningOfString;
-    while (i !=  _endOfString) {    // if we haven't gotten to the end of the buffer yet
-        if(_buffer[i] == '\n'){     // check to see if the buffer contains a complete line terminated with \n
-            lineCount++;            // yes, so increment lineCount
-        }
-        _incrementVariable(&i);     // go to the next character in the buffer
+int RingBuffer::_lineLength(){
+    /*
+
+    Return the number of characters before the first \n in the buffer, or -1 if there
+    are no full lines in the buffer
+
+    */
+
+    if (_lineCount == 0){
+        return -1;
     }
 
-    return lineCount;
+    //the buffer holds at most two runs of characters, the one up to the end of the array
+    //and the one which has wrapped around to the start of it
+    int   firstPart = ((_endOfString >= _beginningOfString) ? _endOfString : INCBUFFERLENGTH) - _beginningOfString;
+    char* newline   = (char*)memchr(_buffer + _beginningOfString, '\n', firstPart);
+    if (newline != NULL){
+        return newline - (_buffer + _beginningOfString);
+    }
+    newline = (char*)memchr(_buffer, '\n', _endOfString);
+    return firstPart + (newline - _buffer);
+}
+
+void RingBuffer::_discardLine(int lineLength){
+    /*
+
+    Remove a line of lineLength characters and its \n from the buffer
+
+    */
+
+    _beginningOfString = (_beginningOfString + lineLength + 1) % INCBUFFERLENGTH;
+    _lineCount--;
+}
+
+int RingBuffer::readLine(char* lineToReturn, int size){
+    /*
+
+    Copy one line (terminated with \n) from the buffer into lineToReturn, without the
+    \n and null terminated.  At most size - 1 characters are copied, the rest of a line
+    which is too long is thrown away.  Returns the number of characters copied, if there
+    are no full lines in the buffer lineToReturn will be empty.
+
+    */
+    int lineLength = _lineLength();
+    if (lineLength < 0){
+        lineToReturn[0] = '\0';
+        return 0;
+    }
+
+    int copyLength = min(lineLength, size - 1);
+    int firstPart  = min(copyLength, INCBUFFERLENGTH - _beginningOfString);
+    memcpy(lineToReturn, _buffer + _beginningOfString, firstPart);
+    memcpy(lineToReturn + firstPart, _buffer, copyLength - firstPart);
+    lineToReturn[copyLength] = '\0';
+
+    _discardLine(lineLength);
+    return copyLength;
 }
 
 void RingBuffer::readLine(String &lineToReturn){
     /*
 
-    Return one line (terminated with \n) from the buffer
+    Return one line (terminated with \n) from the buffer, without the \n
     if there are no full lines in the buffer, passed string will be empty
 
+    The \n is replaced with a null in place so the line can be copied into the string
+    without another buffer, _buffer has a spare null at the end for a line which wraps
+    around.
+
     */
-    lineToReturn = "";            // begin with an empty string
+    int lineLength = _lineLength();
+    if (lineLength < 0){
+        lineToReturn = "";
+        return;
+    }
 
-    if (numberOfLines() > 0) {    // there is at least one full line in the buffer
-        char lastReadValue = '\0';
-        while(lastReadValue != '\n'){   //read until the end of the line is found, building the string
-            lastReadValue = read();
-            lineToReturn += lastReadValue;
-        }
+    int lineEnd = (_beginningOfString + lineLength) % INCBUFFERLENGTH;
+    _buffer[lineEnd] = '\0';
+    lineToReturn = _buffer + _beginningOfString;
+    if (lineEnd < _beginningOfString){
+        lineToReturn += _buffer;
     }
+
+    _discardLine(lineLength);
 }
 
-void RingBuffer::prettyReadLine(String &lineToReturn){
+int RingBuffer::prettyReadLine(char* lineToReturn, int size){
     /*
 
-    Return one line (terminated with \n) from the buffer, but in all uppercase
-    with no leading or trailing whitespaces
+    Copy one line (terminated with \n) from the buffer into lineToReturn the same as
+    readLine(), but in all uppercase with no leading or trailing whitespace.  Returns
+    the length of the line left.
 
     */
-    readLine(lineToReturn);
-    lineToReturn.trim();  // remove leading and trailing white space
-    lineToReturn.toUpperCase();
+    int length = readLine(lineToReturn, size);
+    while (length > 0 && isspace(lineToReturn[length - 1])){
+        length--;
+    }
+    lineToReturn[length] = '\0';
+
+    int start = 0;
+    while (start < length && isspace(lineToReturn[start])){
+        start++;
+    }
+    for (int i = start; i <= length; i++){
+        lineToReturn[i - start] = toupper(lineToReturn[i]);
+    }
+    return length - start;
 }
 
 void RingBuffer::print(){
@@ -205,4 +282,5 @@ void RingBuffer::empty(){
 
     _beginningOfString = 0;
     _endOfString       = 0;
+    _lineCount         = 0;
 }
@@ -29,14 +29,18 @@
             int   spaceAvailable();
             void  empty();
             void  readLine(String&);
-            void  prettyReadLine(String&);
+            int   readLine(char*, int);
+            int   prettyReadLine(char*, int);
         private:
             void _incrementBeginning();
             int  _incrementEnd();
             void _incrementVariable(int* variable);
+            int  _lineLength();
+            void _discardLine(int lineLength);
             int  _beginningOfString = 0;             //points to the first valid character which can be read
             int  _endOfString       = 0;             //points to the first open space which can be written
-            char _buffer[INCBUFFERLENGTH];
+            int  _lineCount         = 0;             //number of \n characters in the buffer
+            char _buffer[INCBUFFERLENGTH + 1] = {};  //the extra character is always null, see readLine()
     };
 
     #endif
@@ -0,0 +1,92 @@
+/*This file is part of the Maslow Control Software.
+
+    The Maslow Control Software is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Maslow Control Software is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with the Maslow Control Software.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2014-2017 Bar Smith*/
+
+    // A fixed size queue for passing records from the main loop to an interrupt,
+    // or the other way around, without turning interrupts off.  Only one side may
+    // push() and only the other side may pop().
+    //
+    // Each side only ever writes its own index and the indices are single bytes,
+    // which the Mega reads and writes in one instruction, so neither side can see
+    // the other's index half changed.  A record is filled in before the head is
+    // moved past it and read before the tail is moved past it, so neither side can
+    // see a record half written either.  One slot is always left empty to tell a
+    // full queue from an empty one, so SIZE - 1 records fit.
+
+    #ifndef SPSCRing_h
+    #define SPSCRing_h
+
+    // Keeps the compiler from moving the record copy past the index update
+    #define SPSCRING_BARRIER() __asm__ __volatile__("" ::: "memory")
+
+    template <class T, byte SIZE>
+    class SPSCRing{
+        static_assert(SIZE >= 2, "SPSCRing needs at least two slots");
+        public:
+            SPSCRing() : _head(0), _tail(0) {}
+
+            bool  empty() const { return _head == _tail; }
+
+            bool  full() const { return _next(_head) == _tail; }
+
+            bool  push(const T& item){
+                /*
+                Adds a copy of item to the queue.  Returns false, and leaves the queue as it
+                was, if it is full.  Only to be called from the producing side.
+                */
+                byte head = _head;
+                byte next = _next(head);
+                if (next == _tail){
+                    return false;
+                }
+                _buffer[head] = item;
+                SPSCRING_BARRIER();
+                _head = next;
+                return true;
+            }
+
+            bool  pop(T& item){
+                /*
+                Copies the oldest record into item and removes it from the queue.  Returns
+                false if the queue is empty.  Only to be called from the consuming side.
+                */
+                byte tail = _tail;
+                if (tail == _head){
+                    return false;
+                }
+                SPSCRING_BARRIER();
+                item = _buffer[tail];
+                SPSCRING_BARRIER();
+                _tail = _next(tail);
+                return true;
+            }
+
+            void  clear(){
+                /*
+                Throws away every record in the queue.  This moves the tail, so it is only
+                safe from the consuming side or with interrupts turned off.
+                */
+                _tail = _head;
+            }
+
+        private:
+            static byte _next(byte index){ return (index + 1 == SIZE) ? 0 : index + 1; }
+            T             _buffer[SIZE];
+            volatile byte _head;             //where the next record will be written, only moved by push()
+            volatile byte _tail;             //the oldest record, only moved by pop() and clear()
+    };
+
+    #endif
@@ -22,6 +22,26 @@ Copyright 2014-2017 Bar Smith*/
 
 #include "Maslow.h"
 #include <EEPROM.h>
+#include <stddef.h>
+
+bool _settingsLoadVersion5(const settingsVersion_t& settingsVersionStruct){
+    /*
+    Loads settings saved by version 5 of the settings, which ended at
+    positionErrorLimit, and returns true if there were some.  The settings
+    added since, chainAcceleration and zAcceleration, are left at their
+    defaults.
+    */
+    const unsigned int length = offsetof(settings_t, chainAcceleration);
+    if (settingsVersionStruct.settingsVersion != 5 ||
+        settingsVersionStruct.eepromValidData != EEPROMVALIDDATA ||
+        EEPROM.read(340 + length) != EEPROMVALIDDATA){
+          return false;
+    }
+    for (unsigned int i = 0; i < length; i++){
+        ((byte*)&sysSettings)[i] = EEPROM.read(340 + i);
+    }
+    return true;
+}
 
 void settingsLoadFromEEprom(){
     /*
@@ -40,8 +60,15 @@ void settingsLoadFromEEprom(){
         tempSettings.eepromValidData == EEPROMVALIDDATA){
           sysSettings = tempSettings;
     }
+    else if (_settingsLoadVersion5(settingsVersionStruct)){
+      // keep the stored settings, written back in the current layout
+      settingsSaveToEEprom();
+    }
     else {
       reportStatusMessage(STATUS_SETTING_READ_FAIL);
+      // the copy in EEPROM is no good, so all of the defaults have to be written
+      // back or it will still be no good after the next change
+      settingsSaveToEEprom();
     }
 
     // Apply settings
@@ -105,14 +132,27 @@ void settingsReset() {
     sysSettings.leftChainTolerance = 0.0;    // float leftChainTolerance;
     sysSettings.rightChainTolerance = 0.0;    // float rightChainTolerance;
     sysSettings.positionErrorLimit = 2.0;  // float positionErrorLimit;
+    sysSettings.chainAcceleration = 100.0;  // float chainAcceleration;
+    sysSettings.zAcceleration = 10.0;   // float zAcceleration;
     sysSettings.eepromValidData = EEPROMVALIDDATA; // byte eepromValidData;
 }
 
+// The part of sysSettings which may differ from the copy in EEPROM, written back
+// a byte at a time by settingsWriteBack()
+unsigned int settingsDirtyStart = 0;    // offset of the next byte to compare
+unsigned int settingsDirtyEnd   = 0;    // one past the last byte to compare
+bool         settingsVersionDirty = false;
+bool         settingsValidDirty   = false;  // eepromValidData is left until last
+
 void settingsWipe(byte resetType){
   /*
   Wipes certain bytes in the EEPROM, you probably want to reset after calling
-  this
+  this.  Any settings not yet written back are thrown away so they don't put
+  back what was wiped.
   */
+  settingsDirtyStart = settingsDirtyEnd = 0;
+  settingsVersionDirty = false;
+  settingsValidDirty   = false;
   if (bit_istrue(resetType, SETTINGS_RESTORE_SETTINGS)){
     for (size_t i = 340 ; i < sizeof(sysSettings) + 340 ; i++) {
       EEPROM.write(i, 0);
@@ -122,6 +162,9 @@ void settingsWipe(byte resetType){
     for (size_t i = 300 ; i < sizeof(sysSettings) + 340; i++) {
       EEPROM.write(i, 0);
     }
+    for (size_t i = STEPSJOURNALSTART ; i < STEPSJOURNALSTART + STEPSJOURNALRECORDS * sizeof(settingsStepsJournal_t); i++) {
+      EEPROM.write(i, 0);
+    }
   }
   else if (bit_istrue(resetType, SETTINGS_RESTORE_ALL)){
     for (size_t i = 0 ; i < EEPROM.length() ; i++) {
@@ -130,47 +173,175 @@ void settingsWipe(byte resetType){
   }
 }
 
+void _settingsMarkDirty(const unsigned int& offset, const unsigned int& length){
+    /*
+    Adds bytes offset to offset + length of sysSettings to the part that needs
+    to be written back
+    */
+    if (settingsDirtyStart >= settingsDirtyEnd){
+        settingsDirtyStart = offset;
+        settingsDirtyEnd   = offset + length;
+    }
+    else {
+        settingsDirtyStart = min(settingsDirtyStart, offset);
+        settingsDirtyEnd   = max(settingsDirtyEnd, offset + length);
+    }
+}
+
 void settingsSaveToEEprom(){
     /*
-    Saves settings to EEPROM, only called when settings change
+    Marks all of the settings to be saved to EEPROM, they are written in the
+    background by settingsWriteBack()
 
     Settings are stored starting at address 340 all the way up.
     */
-    settingsVersion_t settingsVersionStruct = {SETTINGSVERSION, EEPROMVALIDDATA};
-    EEPROM.put(300, settingsVersionStruct);
-    EEPROM.put(340, sysSettings);
+    settingsVersionDirty = true;
+    _settingsMarkDirty(0, sizeof(sysSettings));
+}
+
+bool settingsWriteBack(){
+    /*
+    Writes at most one changed byte of the settings to EEPROM and returns
+    true if there is more to write.  Never waits for the EEPROM, a write takes
+    about 3.3ms during which this returns straight away, so it is cheap enough
+    to call from execSystemRealtime() between motion steps.  Bytes which are
+    already right are skipped without being written.  eepromValidData is
+    written after everything else, so settings which were only partly
+    written aren't loaded.
+    */
+    if (!eeprom_is_ready()){
+        return true;
+    }
+    if (settingsVersionDirty){
+        settingsVersionDirty = false;
+        settingsVersion_t settingsVersionStruct = {SETTINGSVERSION, EEPROMVALIDDATA};
+        for (byte i = 0; i < sizeof(settingsVersionStruct); i++){
+            byte value = ((const byte*)&settingsVersionStruct)[i];
+            if (EEPROM.read(300 + i) != value){
+                EEPROM.write(300 + i, value);
+                settingsVersionDirty = true;   // check the rest on the next call
+                return true;
+            }
+        }
+    }
+    while (settingsDirtyStart < settingsDirtyEnd){
+        unsigned int offset = settingsDirtyStart++;
+        if (offset == offsetof(settings_t, eepromValidData)){
+            settingsValidDirty = true;
+            continue;
+        }
+        byte value = ((const byte*)&sysSettings)[offset];
+        if (EEPROM.read(340 + offset) != value){
+            EEPROM.write(340 + offset, value);
+            return true;
+        }
+    }
+    if (settingsValidDirty){
+        settingsValidDirty = false;
+        unsigned int address = 340 + offsetof(settings_t, eepromValidData);
+        if (EEPROM.read(address) != sysSettings.eepromValidData){
+            EEPROM.write(address, sysSettings.eepromValidData);
+        }
+    }
+    return false;
+}
+
+void settingsFlush(){
+    /*
+    Waits until every changed setting has been written to EEPROM.  Must be
+    called before the settings are read back from EEPROM.
+    */
+    while (settingsWriteBack()){}
+}
+
+// The newest record in the position journal and where the next one will go
+settingsStepsJournal_t stepsJournalLast  = {0, 0, 0, 0, 0};
+bool                   stepsJournalValid = false;    // stepsJournalLast is in the EEPROM
+byte                   stepsJournalNext  = 0;
+
+byte _settingsStepsCRC(const settingsStepsJournal_t& record){
+    /*
+    Returns the CRC-8 of a position journal record, not counting the crc itself.  It
+    starts from EEPROMVALIDDATA so that a blank or wiped record doesn't pass.
+    */
+    const byte* data = (const byte*)&record;
+    byte crc = EEPROMVALIDDATA;
+    for (byte i = 0; i < offsetof(settingsStepsJournal_t, crc); i++){
+        crc ^= data[i];
+        for (byte bit = 0; bit < 8; bit++){
+            crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1;
+        }
+    }
+    return crc;
 }
 
 void settingsSaveStepstoEEprom(){
     /*
     Saves position to EEPROM, is called frequently by execSystemRealtime
 
-    Steps are saved in address 310 -> 339.  Room for expansion for additional
-    axes in the future.
+    Each new position is written to the next record of the journal at
+    STEPSJOURNALSTART, nothing is written if the position hasn't changed since the
+    last one.
     */
     // don't run if old position data has not been incorporated yet
     if (!sys.oldSettingsFlag){
-      settingsStepsV1_t sysSteps = {
-        leftAxis.steps(),
-        rightAxis.steps(),
-        zAxis.steps(),
-        EEPROMVALIDDATA
-      };
-      EEPROM.put(310, sysSteps);
+      settingsStepsJournal_t record;
+      record.lSteps   = leftAxis.steps();
+      record.rSteps   = rightAxis.steps();
+      record.zSteps   = zAxis.steps();
+      record.sequence = stepsJournalLast.sequence + 1;
+      if (record.lSteps == stepsJournalLast.lSteps &&
+          record.rSteps == stepsJournalLast.rSteps &&
+          record.zSteps == stepsJournalLast.zSteps &&
+          stepsJournalValid){
+        return;
+      }
+      record.crc = _settingsStepsCRC(record);
+      EEPROM.put(STEPSJOURNALSTART + stepsJournalNext * sizeof(record), record);
+      stepsJournalLast  = record;
+      stepsJournalValid = true;
+      stepsJournalNext  = (stepsJournalNext + 1) % STEPSJOURNALRECORDS;
+    }
+}
+
+bool _settingsLoadStepsJournal(){
+    /*
+    Finds the newest record in the position journal which passes its CRC.  Returns
+    false if there isn't one.
+    */
+    settingsStepsJournal_t record;
+    stepsJournalValid = false;
+    stepsJournalNext  = 0;
+    for (byte i = 0; i < STEPSJOURNALRECORDS; i++){
+        EEPROM.get(STEPSJOURNALSTART + i * sizeof(record), record);
+        if (record.crc != _settingsStepsCRC(record)){
+            continue;
+        }
+        if (!stepsJournalValid || (int)(record.sequence - stepsJournalLast.sequence) > 0){
+            stepsJournalLast  = record;
+            stepsJournalValid = true;
+            stepsJournalNext  = (i + 1) % STEPSJOURNALRECORDS;
+        }
     }
+    return stepsJournalValid;
 }
 
 void settingsLoadStepsFromEEprom(){
     /*
     Loads position to EEPROM, is called on startup.
 
-    Steps are saved in address 310 -> 339.  Room for expansion for additional
-    axes in the future.
+    The position is taken from the journal, or from address 310 where it was kept
+    by earlier versions.
     */
     settingsStepsV1_t tempStepsV1;
 
     EEPROM.get(310, tempStepsV1);
-    if (tempStepsV1.eepromValidData == EEPROMVALIDDATA){
+    if (_settingsLoadStepsJournal()){
+            leftAxis.setSteps(stepsJournalLast.lSteps);
+            rightAxis.setSteps(stepsJournalLast.rSteps);
+            zAxis.setSteps(stepsJournalLast.zSteps);
+    }
+    else if (tempStepsV1.eepromValidData == EEPROMVALIDDATA){
             leftAxis.setSteps(tempStepsV1.lSteps);
             rightAxis.setSteps(tempStepsV1.rSteps);
             zAxis.setSteps(tempStepsV1.zSteps);
@@ -216,199 +387,242 @@ void settingsLoadOldSteps(){
     }
   }
 
-byte settingsStoreGlobalSetting(const byte& parameter,const float& value){
+// Every $ setting in the order they are reported.  The descriptions are in the same
+// order in settingsNames.
+#define SETTING(id, field, type, hook) {id, offsetof(settings_t, field), type, hook}
+const settingDescriptor_t settingsTable[SETTINGSCOUNT] PROGMEM = {
+    SETTING( 0, machineWidth,        SETTING_FLOAT,   SETTING_HOOK_KINEMATICS),
+    SETTING( 1, machineHeight,       SETTING_FLOAT,   SETTING_HOOK_KINEMATICS),
+    SETTING( 2, distBetweenMotors,   SETTING_FLOAT,   SETTING_HOOK_KINEMATICS),
+    SETTING( 3, motorOffsetY,        SETTING_FLOAT,   SETTING_HOOK_KINEMATICS),
+    SETTING( 4, sledWidth,           SETTING_FLOAT,   SETTING_HOOK_KINEMATICS),
+    SETTING( 5, sledHeight,          SETTING_FLOAT,   SETTING_HOOK_KINEMATICS),
+    SETTING( 6, sledCG,              SETTING_FLOAT,   SETTING_HOOK_KINEMATICS),
+    SETTING( 7, kinematicsType,      SETTING_BYTE,    SETTING_HOOK_KINEMATICS),
+    SETTING( 8, rotationDiskRadius,  SETTING_FLOAT,   SETTING_HOOK_KINEMATICS),
+    SETTING( 9, axisDetachTime,      SETTING_UINT,    SETTING_HOOK_NONE),
+    SETTING(10, chainLength,         SETTING_UINT,    SETTING_HOOK_NONE),
+    SETTING(11, originalChainLength, SETTING_UINT,    SETTING_HOOK_NONE),
+    SETTING(12, encoderSteps,        SETTING_FLOAT,   SETTING_HOOK_ENCODER),
+    SETTING(13, distPerRot,          SETTING_FLOAT,   SETTING_HOOK_DISTPERROT),
+    SETTING(15, maxFeed,             SETTING_UINT,    SETTING_HOOK_NONE),
+    SETTING(16, zAxisAttached,       SETTING_BOOL,    SETTING_HOOK_NONE),
+    SETTING(17, spindleAutomateType, SETTING_SPINDLE, SETTING_HOOK_NONE),
+    SETTING(18, maxZRPM,             SETTING_FLOAT,   SETTING_HOOK_NONE),
+    SETTING(19, zDistPerRot,         SETTING_FLOAT,   SETTING_HOOK_ZDISTPERROT),
+    SETTING(20, zEncoderSteps,       SETTING_FLOAT,   SETTING_HOOK_ZENCODER),
+    SETTING(21, KpPos,               SETTING_FLOAT,   SETTING_HOOK_PID),
+    SETTING(22, KiPos,               SETTING_FLOAT,   SETTING_HOOK_PID),
+    SETTING(23, KdPos,               SETTING_FLOAT,   SETTING_HOOK_PID),
+    SETTING(24, propWeightPos,       SETTING_FLOAT,   SETTING_HOOK_PID),
+    SETTING(25, KpV,                 SETTING_FLOAT,   SETTING_HOOK_PID),
+    SETTING(26, KiV,                 SETTING_FLOAT,   SETTING_HOOK_PID),
+    SETTING(27, KdV,                 SETTING_FLOAT,   SETTING_HOOK_PID),
+    SETTING(28, propWeightV,         SETTING_FLOAT,   SETTING_HOOK_PID),
+    SETTING(29, zKpPos,              SETTING_FLOAT,   SETTING_HOOK_ZPID),
+    SETTING(30, zKiPos,              SETTING_FLOAT,   SETTING_HOOK_ZPID),
+    SETTING(31, zKdPos,              SETTING_FLOAT,   SETTING_HOOK_ZPID),
+    SETTING(32, zPropWeightPos,      SETTING_FLOAT,   SETTING_HOOK_ZPID),
+    SETTING(33, zKpV,                SETTING_FLOAT,   SETTING_HOOK_ZPID),
+    SETTING(34, zKiV,                SETTING_FLOAT,   SETTING_HOOK_ZPID),
+    SETTING(35, zKdV,                SETTING_FLOAT,   SETTING_HOOK_ZPID),
+    SETTING(36, zPropWeightV,        SETTING_FLOAT,   SETTING_HOOK_ZPID),
+    SETTING(37, chainSagCorrection,  SETTING_FLOAT,   SETTING_HOOK_GEOMETRY),
+    SETTING(38, chainOverSprocket,   SETTING_BYTE,    SETTING_HOOK_SPROCKET),
+    SETTING(39, fPWM,                SETTING_BYTE,    SETTING_HOOK_PWM),
+    SETTING(40, leftChainTolerance,  SETTING_FLOAT,   SETTING_HOOK_GEOMETRY),
+    SETTING(41, rightChainTolerance, SETTING_FLOAT,   SETTING_HOOK_GEOMETRY),
+    SETTING(42, positionErrorLimit,  SETTING_FLOAT,   SETTING_HOOK_NONE),
+    SETTING(43, chainAcceleration,   SETTING_FLOAT,   SETTING_HOOK_NONE),
+    SETTING(44, zAcceleration,       SETTING_FLOAT,   SETTING_HOOK_NONE),
+};
+#undef SETTING
+
+const char settingsNames[] PROGMEM =
+    "machine width, mm\0"
+    "machine height, mm\0"
+    "motor distance, mm\0"
+    "motor height, mm\0"
+    "sled width, mm\0"
+    "sled height, mm\0"
+    "sled cg, mm\0"
+    "Kinematics Type 1=Quadrilateral, 2=Triangular\0"
+    "rotation radius, mm\0"
+    "axis idle before detach, ms\0"
+    "full length of chain, mm\0"
+    "calibration chain length, mm\0"
+    "main steps per revolution\0"
+    "distance / rotation, mm\0"
+    "max feed, mm/min\0"
+    "Auto Z Axis, 1 = Yes\0"
+    "auto spindle enable 1=servo, 2=relay_h, 3=relay_l\0"
+    "max z axis RPM\0"
+    "z axis distance / rotation\0"
+    "z axis steps per revolution\0"
+    "main Kp Pos\0"
+    "main Ki Pos\0"
+    "main Kd Pos\0"
+    "main Pos proportional weight\0"
+    "main Kp Velocity\0"
+    "main Ki Velocity\0"
+    "main Kd Velocity\0"
+    "main Velocity proportional weight\0"
+    "z axis Kp Pos\0"
+    "z axis Ki Pos\0"
+    "z axis Kd Pos\0"
+    "z axis Pos proportional weight\0"
+    "z axis Kp Velocity\0"
+    "z axis Ki Velocity\0"
+    "z axis Kd Velocity\0"
+    "z axis Velocity proportional weight\0"
+    "chain sag correction value\0"
+    "chain over sprocket\0"
+    "PWM frequency value 1=39,000Hz, 2=4,100Hz, 3=490Hz\0"
+    "chain tolerance, left chain, mm\0"
+    "chain tolerance, right chain, mm\0"
+    "position error alarm limit, mm\0"
+    "single axis move acceleration, chains, mm/s^2\0"
+    "single axis move acceleration, z axis, mm/s^2";
+
+static_assert(sizeof(settings_t) <= 256, "settingDescriptor_t offsets are only a byte");
+
+float settingsGetValue(const settingDescriptor_t& setting){
     /*
-    Alters individual settings which are then stored to EEPROM.  Returns a
-    status message byte value
+    Returns the current value of a setting
     */
+    byte* address = (byte*)&sysSettings + setting.offset;
+    switch (setting.type){
+        case SETTING_BYTE:    return *address;
+        case SETTING_BOOL:    return *(bool*)address;
+        case SETTING_UINT:    return *(unsigned int*)address;
+        case SETTING_SPINDLE: return *(SpindleAutomationType*)address;
+        default:              return *(float*)address;
+    }
+}
 
-    // We can add whatever sanity checks we want here and error out if we like
-    switch(parameter) {
-        case 0: case 1: case 2: case 3: case 4: case 5: case 6: case 7: case 8:
-            switch(parameter) {
-                case 0:
-                      sysSettings.machineWidth = value;
-                      break;
-                case 1:
-                      sysSettings.machineHeight = value;
-                      break;
-                case 2:
-                      sysSettings.distBetweenMotors = value;
-                      break;
-                case 3:
-                      sysSettings.motorOffsetY = value;
-                      break;
-                case 4:
-                      sysSettings.sledWidth = value;
-                      break;
-                case 5:
-                      sysSettings.sledHeight = value;
-                      break;
-                case 6:
-                      sysSettings.sledCG = value;
-                      break;
-                case 7:
-                      sysSettings.kinematicsType = value;
-                      break;
-                case 8:
-                      sysSettings.rotationDiskRadius = value;
-                      break;
-            }
+void _settingsSetValue(const settingDescriptor_t& setting, const float& value){
+    /*
+    Changes the value of a setting in sysSettings, without saving it or applying it
+    */
+    byte* address = (byte*)&sysSettings + setting.offset;
+    switch (setting.type){
+        case SETTING_BYTE:    *address = value; break;
+        case SETTING_BOOL:    *(bool*)address = value; break;
+        case SETTING_UINT:    *(unsigned int*)address = value; break;
+        case SETTING_SPINDLE: *(SpindleAutomationType*)address = static_cast<SpindleAutomationType>(value); break;
+        default:              *(float*)address = value; break;
+    }
+}
+
+byte _settingsSize(const settingDescriptor_t& setting){
+    /*
+    Returns the number of bytes a setting takes up in sysSettings
+    */
+    switch (setting.type){
+        case SETTING_BYTE:    return sizeof(byte);
+        case SETTING_BOOL:    return sizeof(bool);
+        case SETTING_UINT:    return sizeof(unsigned int);
+        case SETTING_SPINDLE: return sizeof(SpindleAutomationType);
+        default:              return sizeof(float);
+    }
+}
+
+void _settingsOldStepsFound(const byte& flag){
+    /*
+    Marks one of the settings needed to load the old position data as set, and loads
+    it once they all are
+    */
+    if (sys.oldSettingsFlag){
+        bit_false(sys.oldSettingsFlag, flag);
+        if (!sys.oldSettingsFlag){
+            settingsLoadOldSteps();
+        }
+    }
+}
+
+void _settingsRunHook(const byte& hook){
+    /*
+    Applies a setting which has just been changed to the parts of the machine which use it
+    */
+    switch (hook){
+        case SETTING_HOOK_KINEMATICS:
             kinematics.init();
             break;
-        case 9:
-              sysSettings.axisDetachTime = value;
-              break;
-        case 10:
-              sysSettings.chainLength = value;
-              break;
-        case 11:
-              sysSettings.originalChainLength = value;
-              break;
-        case 12:
-              sysSettings.encoderSteps = value;
-              leftAxis.changeEncoderResolution(&sysSettings.encoderSteps);
-              rightAxis.changeEncoderResolution(&sysSettings.encoderSteps);
-              if (sys.oldSettingsFlag){
-                bit_false(sys.oldSettingsFlag, NEED_ENCODER_STEPS);
-                if (!sys.oldSettingsFlag){
-                  settingsLoadOldSteps();
-                }
-              }
-              kinematics.init();
-              break;
-        case 13:
-              sysSettings.distPerRot = value;
-              kinematics.R = (sysSettings.distPerRot)/(2.0 * 3.14159);
-              if (sys.oldSettingsFlag){
-                bit_false(sys.oldSettingsFlag, NEED_DIST_PER_ROT);
-                if (!sys.oldSettingsFlag){
-                  settingsLoadOldSteps();
-                }
-              }
-              kinematics.init();
-              break;
-        case 15:
-              sysSettings.maxFeed = value;
-              break;
-        case 16:
-              sysSettings.zAxisAttached = value;
-              break;
-        case 17: 
-              sysSettings.spindleAutomateType = static_cast<SpindleAutomationType>(value);
-              break;
-        case 18:
-              sysSettings.maxZRPM = value;
-              break;
-        case 19:
-              sysSettings.zDistPerRot = value;
-              zAxis.changePitch(&sysSettings.zDistPerRot);
-              if (sys.oldSettingsFlag){
-                bit_false(sys.oldSettingsFlag, NEED_Z_DIST_PER_ROT);
-                if (!sys.oldSettingsFlag){
-                  settingsLoadOldSteps();
-                }
-              }
-              break;
-        case 20:
-              sysSettings.zEncoderSteps = value;
-              zAxis.changeEncoderResolution(&sysSettings.zEncoderSteps);
-              if (sys.oldSettingsFlag){
-                bit_false(sys.oldSettingsFlag, NEED_Z_ENCODER_STEPS);
-                if (!sys.oldSettingsFlag){
-                  settingsLoadOldSteps();
-                }
-              }
-              break;
-        case 21: case 22: case 23: case 24: case 25: case 26: case 27: case 28:
-            switch(parameter) {
-                case 21:
-                      sysSettings.KpPos = value;
-                      break;
-                case 22:
-                      sysSettings.KiPos = value;
-                      break;
-                case 23:
-                      sysSettings.KdPos = value;
-                      break;
-                case 24:
-                      sysSettings.propWeightPos = value;
-                      break;
-                case 25:
-                      sysSettings.KpV = value;
-                      break;
-                case 26:
-                      sysSettings.KiV = value;
-                      break;
-                case 27:
-                      sysSettings.KdV = value;
-                      break;
-                case 28:
-                      sysSettings.propWeightV = value;
-                      break;
-                }
-                leftAxis.setPIDValues(&sysSettings.KpPos, &sysSettings.KiPos, &sysSettings.KdPos, &sysSettings.propWeightPos, &sysSettings.KpV, &sysSettings.KiV, &sysSettings.KdV, &sysSettings.propWeightV);
-                rightAxis.setPIDValues(&sysSettings.KpPos, &sysSettings.KiPos, &sysSettings.KdPos, &sysSettings.propWeightPos, &sysSettings.KpV, &sysSettings.KiV, &sysSettings.KdV, &sysSettings.propWeightV);
-                break;
-        case 29: case 30: case 31: case 32: case 33: case 34: case 35: case 36:
-            switch(parameter) {
-                case 29:
-                      sysSettings.zKpPos = value;
-                      break;
-                case 30:
-                      sysSettings.zKiPos = value;
-                      break;
-                case 31:
-                      sysSettings.zKdPos = value;
-                      break;
-                case 32:
-                      sysSettings.zPropWeightPos = value;
-                      break;
-                case 33:
-                      sysSettings.zKpV = value;
-                      break;
-                case 34:
-                      sysSettings.zKiV = value;
-                      break;
-                case 35:
-                      sysSettings.zKdV = value;
-                      break;
-                case 36:
-                      sysSettings.zPropWeightV = value;
-                      break;
-            }
+        case SETTING_HOOK_GEOMETRY:
+            kinematics.recomputeGeometry();
+            break;
+        case SETTING_HOOK_ENCODER:
+            leftAxis.changeEncoderResolution(&sysSettings.encoderSteps);
+            rightAxis.changeEncoderResolution(&sysSettings.encoderSteps);
+            _settingsOldStepsFound(NEED_ENCODER_STEPS);
+            kinematics.init();
+            break;
+        case SETTING_HOOK_DISTPERROT:
+            leftAxis.changePitch(&sysSettings.distPerRot);
+            rightAxis.changePitch(&sysSettings.distPerRot);
+            kinematics.R = (sysSettings.distPerRot)/(2.0 * 3.14159);
+            _settingsOldStepsFound(NEED_DIST_PER_ROT);
+            kinematics.init();
+            break;
+        case SETTING_HOOK_ZDISTPERROT:
+            zAxis.changePitch(&sysSettings.zDistPerRot);
+            _settingsOldStepsFound(NEED_Z_DIST_PER_ROT);
+            break;
+        case SETTING_HOOK_ZENCODER:
+            zAxis.changeEncoderResolution(&sysSettings.zEncoderSteps);
+            _settingsOldStepsFound(NEED_Z_ENCODER_STEPS);
+            break;
+        case SETTING_HOOK_PID:
+            leftAxis.setPIDValues(&sysSettings.KpPos, &sysSettings.KiPos, &sysSettings.KdPos, &sysSettings.propWeightPos, &sysSettings.KpV, &sysSettings.KiV, &sysSettings.KdV, &sysSettings.propWeightV);
+            rightAxis.setPIDValues(&sysSettings.KpPos, &sysSettings.KiPos, &sysSettings.KdPos, &sysSettings.propWeightPos, &sysSettings.KpV, &sysSettings.KiV, &sysSettings.KdV, &sysSettings.propWeightV);
+            break;
+        case SETTING_HOOK_ZPID:
             zAxis.setPIDValues(&sysSettings.zKpPos, &sysSettings.zKiPos, &sysSettings.zKdPos, &sysSettings.zPropWeightPos, &sysSettings.zKpV, &sysSettings.zKiV, &sysSettings.zKdV, &sysSettings.zPropWeightV);
             break;
-        case 37:
-              sysSettings.chainSagCorrection = value;
-              break;
-        case 38:
-              settingsSaveStepstoEEprom();
-              sysSettings.chainOverSprocket = value;
-              setupAxes();
-              settingsLoadStepsFromEEprom();
-              // Set initial desired position of the machine to its current position
-              leftAxis.write(leftAxis.read());
-              rightAxis.write(rightAxis.read());
-              zAxis.write(zAxis.read());
-              kinematics.init();
-              break;
-        case 39:
-              sysSettings.fPWM = value;
-              setPWMPrescalers(value);
-              break;
-        case 40:
-              sysSettings.leftChainTolerance = value;
-              break;
-        case 41:
-              sysSettings.rightChainTolerance = value;
-              break;
-        case 42:
-              sysSettings.positionErrorLimit = value;
-              break;
-        default:
-              return(STATUS_INVALID_STATEMENT);
+        case SETTING_HOOK_SPROCKET:
+            settingsSaveStepstoEEprom();
+            setupAxes();
+            settingsLoadStepsFromEEprom();
+            // Set initial desired position of the machine to its current position
+            leftAxis.write(leftAxis.read());
+            rightAxis.write(rightAxis.read());
+            zAxis.write(zAxis.read());
+            plannerSetZPosition(zAxis.read());
+            kinematics.init();
+            break;
+        case SETTING_HOOK_PWM:
+            setPWMPrescalers(sysSettings.fPWM);
+            break;
     }
-    settingsSaveToEEprom();
+}
+
+byte settingsStoreGlobalSetting(const byte& parameter,const float& value){
+    /*
+    Alters individual settings which are then stored to EEPROM.  Returns a
+    status message byte value
+    */
+    settingDescriptor_t setting;
+    byte i = 0;
+    do {
+        if (i == SETTINGSCOUNT){
+            return(STATUS_INVALID_STATEMENT);
+        }
+        memcpy_P(&setting, &settingsTable[i++], sizeof(setting));
+    } while (setting.id != parameter);
+
+    // Whole number settings can't be negative or larger than they can hold
+    if (setting.type != SETTING_FLOAT){
+        if (value < 0){
+            return(STATUS_NEGATIVE_VALUE);
+        }
+        if ((setting.type == SETTING_UINT && value > 65535) || (setting.type != SETTING_UINT && value > 255)){
+            return(STATUS_INVALID_STATEMENT);
+        }
+    }
+
+    _settingsSetValue(setting, value);
+    _settingsRunHook(setting.hook);
+    settingsVersionDirty = true;
+    _settingsMarkDirty(setting.offset, _settingsSize(setting));
     return(STATUS_OK);
 }
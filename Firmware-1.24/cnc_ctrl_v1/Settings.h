@@ -20,9 +20,10 @@ Copyright 2014-2017 Bar Smith*/
 #ifndef settings_h
 #define settings_h
 
-#define SETTINGSVERSION 5      // The current version of settings, if this doesn't
+#define SETTINGSVERSION 6      // The current version of settings, if this doesn't
                                // match what is in EEPROM then settings on
-                               // machine are reset to defaults
+                               // machine are reset to defaults, except for
+                               // version 5 which is carried over
 #define EEPROMVALIDDATA 56     // This is just a random byte value that is used 
                                // to determine if the data in the EEPROM was 
                                // saved by maslow, or something else.
@@ -81,11 +82,45 @@ typedef struct {  // I think this is about ~128 bytes in size if I counted corre
   float leftChainTolerance;
   float rightChainTolerance;
   float positionErrorLimit;
+  float chainAcceleration;
+  float zAcceleration;
   byte eepromValidData;  // This should always be last, that way if an error
                          // happens in writing, it will not be written and we
 } settings_t;            // will know to reset the settings
 extern settings_t sysSettings;
 
+// The kinds of value a setting can hold
+#define SETTING_FLOAT   0
+#define SETTING_BYTE    1
+#define SETTING_BOOL    2
+#define SETTING_UINT    3
+#define SETTING_SPINDLE 4   // a SpindleAutomationType
+
+// What has to be redone after a setting has been changed
+#define SETTING_HOOK_NONE        0
+#define SETTING_HOOK_KINEMATICS  1
+#define SETTING_HOOK_GEOMETRY    2
+#define SETTING_HOOK_ENCODER     3
+#define SETTING_HOOK_DISTPERROT  4
+#define SETTING_HOOK_ZDISTPERROT 5
+#define SETTING_HOOK_ZENCODER    6
+#define SETTING_HOOK_PID         7
+#define SETTING_HOOK_ZPID        8
+#define SETTING_HOOK_SPROCKET    9
+#define SETTING_HOOK_PWM         10
+
+// Describes one of the $ settings, the table of them is kept in flash
+typedef struct {
+  byte id;                    // The $ number
+  byte offset;                // Where it is in settings_t
+  byte type;                  // SETTING_FLOAT etc.
+  byte hook;                  // SETTING_HOOK_NONE etc.
+} settingDescriptor_t;
+
+#define SETTINGSCOUNT 44      // The number of $ settings
+extern const settingDescriptor_t settingsTable[SETTINGSCOUNT] PROGMEM;
+extern const char settingsNames[] PROGMEM;
+
 typedef struct {
   byte settingsVersion;
   byte eepromValidData;
@@ -98,12 +133,29 @@ typedef struct {
   byte eepromValidData;
 } settingsStepsV1_t;
 
+// The position is saved to a ring of records so that the same few bytes of EEPROM
+// aren't written every time the machine stops, the newest good record is loaded
+// on startup
+#define STEPSJOURNALSTART   1024   // EEPROM address of the first record
+#define STEPSJOURNALRECORDS 128    // The number of records in the ring
+
+typedef struct {
+  int32_t lSteps;
+  int32_t rSteps;
+  int32_t zSteps;
+  unsigned int sequence;       // One more than the record written before it
+  byte crc;                    // Of everything above, a partly written record won't match
+} settingsStepsJournal_t;
+
 void settingsLoadFromEEprom();
 void settingsReset();
 void settingsWipe(byte);
 void settingsSaveToEEprom();
+bool settingsWriteBack();
+void settingsFlush();
 void settingsSaveStepstoEEprom();
 void settingsLoadStepsFromEEprom();
 byte settingsStoreGlobalSetting(const byte&,const float&);
+float settingsGetValue(const settingDescriptor_t&);
 
 #endif
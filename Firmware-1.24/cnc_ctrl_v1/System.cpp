@@ -399,11 +399,14 @@ void maslowDelay(unsigned long waitTimeMs) {
 // by this command should be relatively fast.  Should always check for sys.stop
 // after returning from this function
 void execSystemRealtime(){
+    PROFILESTART(PROFILE_REALTIME);
     readSerialCommands();
     returnPoz();
     systemSaveAxesPosition();
+    settingsWriteBack();
     motionDetachIfIdle();
     // check systemRtExecAlarm flag and do stuff
+    PROFILEEND(PROFILE_REALTIME);
 }
 
 void systemSaveAxesPosition(){
@@ -423,6 +426,7 @@ void systemReset(){
     rightAxis.detach();
     zAxis.detach();
     setSpindlePower(false);
+    settingsFlush();
     // Reruns the initial setup function and calls stop to re-init state
     sys.stop = true;
     setup();
@@ -536,6 +540,32 @@ byte systemExecuteCmdstring(String& cmdString){
           //         settings_store_build_info(line);
           //       }
           //       break;
+              case 'F' : // Status frames.  Sends reportStatusFrame() every so many ms instead of the text reports, 0 turns them off
+                char_counter++;
+                if (cmdString[char_counter++] != '=') { return(STATUS_INVALID_STATEMENT); }
+                if (!readFloat(cmdString, char_counter, value) || (value < 0)) { return(STATUS_BAD_NUMBER_FORMAT); }
+                if (cmdString[char_counter] != 0) { return(STATUS_INVALID_STATEMENT); }
+                sys.statusFrameInterval = (value > 0) ? min(max(value, MINSTATUSFRAMEINTERVAL), MAXSTATUSFRAMEINTERVAL) : 0;
+                break;
+              #if PROFILING > 0
+              case 'P' : // Timing of the control loop since the last $P
+                if (cmdString.length() != 2) { return(STATUS_INVALID_STATEMENT); }
+                reportProfile();
+                break;
+              #endif
+              case 'S' : // Streaming mode.  The host may send lines as long as they fit in the buffer
+                if (cmdString.length() == 2) {
+                  reportBufferSize();
+                  break;
+                }
+                if (cmdString[++char_counter] != '=') { return(STATUS_INVALID_STATEMENT); }
+                if (cmdString.length() != 4) { return(STATUS_INVALID_STATEMENT); }
+                switch (cmdString[++char_counter]) {
+                  case '0': sys.streaming = false; break;
+                  case '1': sys.streaming = true; break;
+                  default: return(STATUS_INVALID_STATEMENT);
+                }
+                break;
               case 'R' : // Restore defaults [IDLE/ALARM]
                 if (cmdString[++char_counter] != 'S') { return(STATUS_INVALID_STATEMENT); }
                 if (cmdString[++char_counter] != 'T') { return(STATUS_INVALID_STATEMENT); }
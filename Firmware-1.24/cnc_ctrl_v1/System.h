@@ -64,6 +64,8 @@ typedef struct {
   int   nextTool;             //Stores the value of the next tool number eg: T4 -> 4
   float inchesToMMConversion; //Used to track whether to convert from inches, can probably be done in a way that doesn't require RAM
   float feedrate;             //The feedrate of the machine in mm/min
+  bool  streaming;            //Set by $S=1, each ok reports the space left in the incoming buffer
+  unsigned int statusFrameInterval; //Set by $F=ms, if not 0 hex status frames are sent this often instead of the text reports
   // THE FOLLOWING IS USED FOR IMPORTING SETTINGS FROM FIRMWARE v1.00 AND EARLIER 
   // It can be deleted at some point
   byte oldSettingsFlag;
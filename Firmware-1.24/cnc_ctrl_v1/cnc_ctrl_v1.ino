@@ -67,31 +67,26 @@ void setup(){
     leftAxis.write(leftAxis.read());
     rightAxis.write(rightAxis.read());
     zAxis.write(zAxis.read());
-    readyCommandString.reserve(INCBUFFERLENGTH);           //Allocate memory so that this string doesn't fragment the heap as it grows and shrinks
-    gcodeLine.reserve(INCBUFFERLENGTH);
+    plannerSetZPosition(zAxis.read());
+    readyCommandString.reserve(EXPGCODELINE);           //Allocate memory so that this string doesn't fragment the heap as it grows and shrinks
+    gcodeLine.reserve(EXPGCODELINE);
 
     #ifndef SIMAVR // Using the timer will crash simavr, so we disable it.
                    // Instead, we'll run runsOnATimer periodically in loop().
-    Timer1.initialize(LOOPINTERVAL);
+    Timer1.initialize(VELOCITYLOOPINTERVAL);
     Timer1.attachInterrupt(runsOnATimer);
     #endif
     
     Serial.println(F("Grbl v1.00"));  // Why GRBL?  Apparently because some programs are silly and look for this as an initialization command
     Serial.println(F("ready"));
+    reportBufferSize();
     reportStatusMessage(STATUS_OK);
 
 }
 
 void runsOnATimer(){
-    #if misloopDebug > 0
-    if (inMovementLoop && !movementUpdated){
-        movementFail = true;
-    }
-    #endif
-    movementUpdated = false;
-    leftAxis.computePID();
-    rightAxis.computePID();
-    zAxis.computePID();
+    // The body is motionRunControlLoops() so the native build runs the same code
+    motionRunControlLoops();
 }
 
 void loop(){
@@ -110,6 +105,12 @@ void loop(){
                                  // limit
     while (!sys.stop){
         gcodeExecuteLoop();
+        executePlannedMoves();
+        #if KINEMATICSCACHE > 0
+        if (incSerialBuffer.numberOfLines() == 0 && plannerIsEmpty()){
+            kinematics.updateCache(); // fill in the chain length cache while idle
+        }
+        #endif
         #ifdef SIMAVR // Normally, runsOnATimer() will, well, run on a timer. See also setup().
         runsOnATimer();
         #endif
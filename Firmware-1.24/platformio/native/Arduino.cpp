@@ -0,0 +1,157 @@
+/*This file is part of the Maslow Control Software.
+    The Maslow Control Software is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    Maslow Control Software is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with the Maslow Control Software.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2014-2017 Bar Smith*/
+
+// Definitions for the native Arduino stand-in, see Arduino.h
+
+#include <chrono>
+#include <thread>
+#include <Arduino.h>
+#include <EEPROM.h>
+
+HardwareSerial Serial;
+EEPROMClass    EEPROM;
+
+void (*nativeTimerInterrupt)() = NULL;
+
+volatile uint8_t  nativePort;
+volatile uint8_t  TCCR0A, TCCR0B, TCCR1A, TCCR1B, TCCR2A, TCCR2B, TCCR3A, TCCR3B;
+volatile uint8_t  TCCR4A, TCCR4B, TCCR5A, TCCR5B, OCR0A, OCR0B, OCR2A, OCR2B;
+volatile uint8_t  TIMSK1, SREG;
+volatile uint16_t OCR1A, OCR1B, OCR1C, OCR3A, OCR3B, OCR3C, OCR4A, OCR4B, OCR4C;
+volatile uint16_t OCR5A, OCR5B, OCR5C, ICR1, TCNT1;
+
+static const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+unsigned long micros(){
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+unsigned long millis(){
+    return micros() / 1000;
+}
+
+void delay(unsigned long ms){
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void delayMicroseconds(unsigned int us){
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+void pinMode(int, int)      {}
+void digitalWrite(int, int) {}
+int  digitalRead(int)       { return LOW; }
+void analogWrite(int, int)  {}
+void attachInterrupt(uint8_t, void (*)(), int) {}
+
+long random(long low, long high){
+    return low + rand() % (high - low);
+}
+
+String::String(double value, int decimalPlaces){
+    char buffer[40];
+    snprintf(buffer, sizeof(buffer), "%.*f", decimalPlaces, value);
+    _s = buffer;
+}
+
+int String::indexOf(char c, unsigned int from) const{
+    size_t index = _s.find(c, from);
+    return index == std::string::npos ? -1 : (int)index;
+}
+
+String String::substring(unsigned int from, unsigned int to) const{
+    if (from > _s.size()){ from = _s.size(); }
+    if (to > _s.size()){ to = _s.size(); }
+    if (to < from){ return String(); }
+    return String(_s.substr(from, to - from));
+}
+
+void String::trim(){
+    size_t first = _s.find_first_not_of(" \t\r\n");
+    if (first == std::string::npos){
+        _s.clear();
+        return;
+    }
+    size_t last = _s.find_last_not_of(" \t\r\n");
+    _s = _s.substr(first, last - first + 1);
+}
+
+void String::toUpperCase(){
+    for (size_t i = 0; i < _s.size(); i++){
+        _s[i] = toupper(_s[i]);
+    }
+}
+
+size_t Print::write(const uint8_t* buffer, size_t size){
+    for (size_t i = 0; i < size; i++){
+        write(buffer[i]);
+    }
+    return size;
+}
+
+size_t Print::print(const char* cstr){
+    size_t n = 0;
+    while (*cstr){
+        n += write(*cstr++);
+    }
+    return n;
+}
+
+size_t Print::print(long value, int base){
+    char buffer[40];
+    snprintf(buffer, sizeof(buffer), base == HEX ? "%lX" : "%ld", value);
+    return print(buffer);
+}
+
+size_t Print::print(unsigned long value, int base){
+    char buffer[40];
+    snprintf(buffer, sizeof(buffer), base == HEX ? "%lX" : "%lu", value);
+    return print(buffer);
+}
+
+size_t Print::print(double value, int decimalPlaces){
+    char buffer[40];
+    snprintf(buffer, sizeof(buffer), "%.*f", decimalPlaces, value);
+    return print(buffer);
+}
+
+int HardwareSerial::available(){
+    if (nativeTimerInterrupt){
+        nativeTimerInterrupt();
+    }
+    return _input.size() - _inputPosition;
+}
+
+int HardwareSerial::read(){
+    if (_inputPosition >= _input.size()){
+        return -1;
+    }
+    char c = _input[_inputPosition++];
+    if (_inputPosition == _input.size()){
+        _input.clear();
+        _inputPosition = 0;
+    }
+    return c;
+}
+
+size_t HardwareSerial::write(uint8_t c){
+    if (output){
+        fputc(c, output);
+    }
+    return 1;
+}
+
+void HardwareSerial::feed(const char* cstr){
+    _input += cstr;
+}
@@ -0,0 +1,233 @@
+/*This file is part of the Maslow Control Software.
+    The Maslow Control Software is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    Maslow Control Software is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with the Maslow Control Software.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2014-2017 Bar Smith*/
+
+// A thin stand-in for the Arduino core which lets the Firmware be compiled
+// and run on the host computer by the native PlatformIO environment.  Only the
+// parts of the core which the Firmware actually uses are here.  Pins read as
+// LOW and writes to them are ignored, Serial reads from and writes to memory
+// so that the checks and the benchmark can feed it gcode.
+
+#ifndef native_Arduino_h
+#define native_Arduino_h
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include <string>
+
+// Pretend to be a Mega so that the encoder library picks the same interrupt
+// pins it does on the real board.
+#ifndef __AVR__
+#define __AVR__
+#endif
+#ifndef __AVR_ATmega2560__
+#define __AVR_ATmega2560__
+#endif
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+typedef uint8_t byte;
+typedef bool    boolean;
+
+#define HIGH         1
+#define LOW          0
+#define INPUT        0
+#define OUTPUT       1
+#define INPUT_PULLUP 2
+#define CHANGE       1
+
+#define DEC 10
+#define HEX 16
+
+static const uint8_t A6 = 60;
+static const uint8_t A7 = 61;
+
+#define B000011 3
+#define B000100 4
+#define B000111 7
+#define B110100 52
+#define B111101 61
+#define B111110 62
+#define B111111 63
+
+#define bit(b)                  (1UL << (b))
+#define constrain(amt,low,high) ((amt)<(low)?(low):((amt)>(high)?(high):(amt)))
+#define sq(x)                   ((x)*(x))
+#define min(a,b)                ((a)<(b)?(a):(b))
+#define max(a,b)                ((a)>(b)?(a):(b))
+using std::abs;
+
+inline bool isDigit(int c){ return isdigit(c); }
+inline bool isPunct(int c){ return ispunct(c); }
+
+// Program memory is ordinary memory on the host
+#define PROGMEM
+#define PGM_P                 const char*
+#define pgm_read_byte(addr)   (*(const uint8_t*)(addr))
+#define pgm_read_word(addr)   (*(const uint16_t*)(addr))
+#define pgm_read_dword(addr)  (*(const uint32_t*)(addr))
+#define pgm_read_float(addr)  (*(const float*)(addr))
+#define pgm_read_ptr(addr)    (*(void* const*)(addr))
+#define memcpy_P              memcpy
+#define strlen_P              strlen
+
+class __FlashStringHelper;
+#define F(string_literal) (reinterpret_cast<const __FlashStringHelper*>(string_literal))
+
+#define noInterrupts()
+#define interrupts()
+
+// Timers used by analogWrite(), only needed so that Motor.cpp compiles
+#define NOT_A_PIN    0
+#define NOT_ON_TIMER 0
+#define TIMER0A  1
+#define TIMER0B  2
+#define TIMER1A  3
+#define TIMER1B  4
+#define TIMER1C  5
+#define TIMER2   6
+#define TIMER2A  7
+#define TIMER2B  8
+#define TIMER3A  9
+#define TIMER3B  10
+#define TIMER3C  11
+#define TIMER4A  12
+#define TIMER4B  13
+#define TIMER4C  14
+#define TIMER4D  15
+#define TIMER5A  16
+#define TIMER5B  17
+#define TIMER5C  18
+
+// Every pin lives on one fake port
+extern volatile uint8_t nativePort;
+inline uint8_t digitalPinToTimer(int)   { return NOT_ON_TIMER; }
+inline uint8_t digitalPinToPort(int)    { return 1; }
+inline uint8_t digitalPinToBitMask(int) { return 1; }
+#define portOutputRegister(port) (&nativePort)
+#define portInputRegister(port)  (&nativePort)
+#define portModeRegister(port)   (&nativePort)
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void pinMode(int pin, int mode);
+void digitalWrite(int pin, int value);
+int  digitalRead(int pin);
+void analogWrite(int pin, int value);
+long random(long low, long high);
+void attachInterrupt(uint8_t interrupt, void (*isr)(), int mode);
+
+// There is no timer interrupt on the host.  Instead the function set here is
+// called every time the Firmware polls Serial.available(), which it does from
+// every loop that waits on the PID loop, so moves run as fast as the host can
+// compute them.
+extern void (*nativeTimerInterrupt)();
+
+class String {
+    public:
+        String(const char* cstr = "")    : _s(cstr) {}
+        String(const std::string& s)     : _s(s) {}
+        String(char c)                   : _s(1, c) {}
+        String(int value)                : _s(std::to_string(value)) {}
+        String(unsigned int value)       : _s(std::to_string(value)) {}
+        String(long value)               : _s(std::to_string(value)) {}
+        String(unsigned long value)      : _s(std::to_string(value)) {}
+        String(double value, int decimalPlaces = 2);
+
+        unsigned int length() const                 { return _s.size(); }
+        const char*  c_str() const                  { return _s.c_str(); }
+        char         operator[](unsigned int i) const { return i < _s.size() ? _s[i] : 0; }
+        char&        operator[](unsigned int i)     { return _s[i]; }
+        int          indexOf(char c, unsigned int from = 0) const;
+        String       substring(unsigned int from, unsigned int to) const;
+        String       substring(unsigned int from) const { return substring(from, _s.size()); }
+        float        toFloat() const                { return atof(_s.c_str()); }
+        long         toInt() const                  { return atol(_s.c_str()); }
+        void         trim();
+        void         toUpperCase();
+        void         remove(unsigned int index, unsigned int count) { _s.erase(index, count); }
+        void         reserve(unsigned int size)     { _s.reserve(size); }
+        bool         concat(const String& s)        { _s += s._s; return true; }
+        bool         concat(const char* cstr)       { _s += cstr; return true; }
+        bool         concat(char c)                 { _s += c; return true; }
+        bool         concat(double value)           { _s += String(value)._s; return true; }
+
+        String& operator+=(const String& s)         { _s += s._s; return *this; }
+        String& operator+=(const char* cstr)        { _s += cstr; return *this; }
+        String& operator+=(char c)                  { _s += c; return *this; }
+        bool    operator==(const char* cstr) const  { return _s == cstr; }
+        bool    operator!=(const char* cstr) const  { return _s != cstr; }
+        bool    operator==(const String& s) const   { return _s == s._s; }
+
+        friend String operator+(const String& a, const String& b) { return String(a._s + b._s); }
+        friend String operator+(const String& a, const char* b)   { return String(a._s + b); }
+        friend String operator+(const String& a, char b)          { return String(a._s + b); }
+        friend String operator+(const String& a, double b)        { return String(a._s + String(b)._s); }
+
+    private:
+        std::string _s;
+};
+
+class Print {
+    public:
+        virtual ~Print() {}
+        virtual size_t write(uint8_t c) = 0;
+        size_t write(const uint8_t* buffer, size_t size);
+
+        size_t print(const char* cstr);
+        size_t print(const __FlashStringHelper* fstr) { return print(reinterpret_cast<const char*>(fstr)); }
+        size_t print(const String& s)                 { return print(s.c_str()); }
+        size_t print(char c)                          { return write(c); }
+        size_t print(unsigned char value, int base = DEC) { return print((unsigned long)value, base); }
+        size_t print(int value, int base = DEC)           { return print((long)value, base); }
+        size_t print(unsigned int value, int base = DEC)  { return print((unsigned long)value, base); }
+        size_t print(long value, int base = DEC);
+        size_t print(unsigned long value, int base = DEC);
+        size_t print(double value, int decimalPlaces = 2);
+
+        size_t println()                              { return print("\r\n"); }
+        template<typename T> size_t println(T value)  { size_t n = print(value); return n + println(); }
+        template<typename T> size_t println(T value, int format) { size_t n = print(value, format); return n + println(); }
+};
+
+class HardwareSerial : public Print {
+    public:
+        void   begin(unsigned long baud) {}
+        int    available();
+        int    availableForWrite()       { return 63; }
+        int    read();
+        void   flush()                   { if (output) { fflush(output); } }
+        size_t write(uint8_t c) override;
+        using  Print::write;
+
+        void   feed(const char* cstr);   // queues characters to be read by the Firmware
+        FILE*  output = stdout;          // where the Firmware's output goes, NULL to discard it
+
+    private:
+        std::string _input;
+        size_t      _inputPosition = 0;
+};
+
+extern HardwareSerial Serial;
+
+void setup();
+void loop();
+
+#endif
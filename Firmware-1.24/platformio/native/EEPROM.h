@@ -0,0 +1,49 @@
+/*This file is part of the Maslow Control Software.
+    The Maslow Control Software is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    Maslow Control Software is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with the Maslow Control Software.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2014-2017 Bar Smith*/
+
+// The EEPROM of the native build is 4kB of RAM which starts out blank every
+// time the program is run.
+
+#ifndef native_EEPROM_h
+#define native_EEPROM_h
+
+#include <stdint.h>
+#include <string.h>
+
+#define NATIVEEEPROMSIZE 4096
+
+// Writes finish at once, so the EEPROM is always ready for the next one
+#define eeprom_is_ready() (1)
+
+struct EEPROMClass{
+    uint8_t  read(int address)                 { return _memory[address]; }
+    void     write(int address, uint8_t value) { _memory[address] = value; }
+    void     update(int address, uint8_t value){ _memory[address] = value; }
+    uint16_t length()                          { return NATIVEEEPROMSIZE; }
+
+    template<typename T> T& get(int address, T& t){
+        memcpy(&t, _memory + address, sizeof(T));
+        return t;
+    }
+    template<typename T> const T& put(int address, const T& t){
+        memcpy(_memory + address, &t, sizeof(T));
+        return t;
+    }
+
+    uint8_t  _memory[NATIVEEEPROMSIZE];
+};
+
+extern EEPROMClass EEPROM;
+
+#endif
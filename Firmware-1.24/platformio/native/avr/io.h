@@ -0,0 +1,49 @@
+/*This file is part of the Maslow Control Software.
+    The Maslow Control Software is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    Maslow Control Software is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with the Maslow Control Software.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2014-2017 Bar Smith*/
+
+// Stand-in for the ATmega2560 register file used by the native build.  The
+// timer registers are plain variables so that the PWM frequency and TimerOne
+// code compiles and runs, they don't do anything.
+
+#ifndef native_avr_io_h
+#define native_avr_io_h
+
+#include <stdint.h>
+
+extern volatile uint8_t  TCCR0A, TCCR0B, TCCR1A, TCCR1B, TCCR2A, TCCR2B, TCCR3A, TCCR3B;
+extern volatile uint8_t  TCCR4A, TCCR4B, TCCR5A, TCCR5B, OCR0A, OCR0B, OCR2A, OCR2B;
+extern volatile uint8_t  TIMSK1, SREG;
+extern volatile uint16_t OCR1A, OCR1B, OCR1C, OCR3A, OCR3B, OCR3C, OCR4A, OCR4B, OCR4C;
+extern volatile uint16_t OCR5A, OCR5B, OCR5C, ICR1, TCNT1;
+
+#define COM0A1 7
+#define COM0B1 5
+#define COM1A1 7
+#define COM1B1 5
+#define COM1C1 3
+#define COM2A1 7
+#define COM2B1 5
+#define COM3A1 7
+#define COM3B1 5
+#define COM3C1 3
+#define COM4A1 7
+#define COM4B1 5
+#define COM4C1 3
+#define COM5A1 7
+#define COM5B1 5
+#define COM5C1 3
+
+#define _BV(b) (1 << (b))
+
+#endif
@@ -0,0 +1,436 @@
+/*This file is part of the Maslow Control Software.
+    The Maslow Control Software is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    Maslow Control Software is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with the Maslow Control Software.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2014-2017 Bar Smith*/
+
+// Benchmarks the gcode parser, kinematics, PID and motion planner on the host
+// computer, after running the checks in checks.cpp.  Build and run it with:
+//
+//     pio run -e native && .pioenvs/native/program [file.nc]
+//
+// If a gcode file is given it is run through the Firmware the same way it
+// would be sent by Ground Control, otherwise a generated test pattern is used.
+// The numbers are only useful for comparing one build against another on the
+// same computer, the Mega is a great deal slower.
+
+#include <chrono>
+#include <vector>
+#include <string>
+#include "Maslow.h"
+#include "checks.h"
+
+// These are defined in cnc_ctrl_v1.ino on the real board
+system_t sys;
+settings_t sysSettings;
+byte systemRtExecAlarm;
+Axis leftAxis;
+Axis rightAxis;
+Axis zAxis;
+Kinematics kinematics;
+
+static unsigned long pidTicks = 0;     // number of times the PID loop has been run
+static volatile float sink;            // keeps the compiler from optimizing away the work being timed
+
+void runsOnATimer(){
+    /*
+    Stands in for the Timer1 interrupt of the real board, called by the native
+    Serial.available()
+    */
+    if (motionRunControlLoops()){
+        pidTicks++;
+    }
+}
+
+void setup(){
+    /*
+    The same start up as the real board, except that the machine is placed in the
+    middle of the sheet because the native EEPROM starts out empty, and the position
+    error alarm is turned off because the native motors never move
+    */
+    sys.inchesToMMConversion = 1;
+    sys.state = STATE_POS_ERR_IGNORE;
+    settingsLoadFromEEprom();
+    setupAxes();
+    settingsLoadStepsFromEEprom();
+
+    float aChainLength;
+    float bChainLength;
+    kinematics.inverse(0, 0, &aChainLength, &bChainLength);
+    leftAxis.set(aChainLength);
+    rightAxis.set(bChainLength);
+    zAxis.set(0);
+    leftAxis.write(leftAxis.read());
+    rightAxis.write(rightAxis.read());
+    zAxis.write(zAxis.read());
+    sys.xPosition = 0;
+    sys.yPosition = 0;
+
+    sys.stop = false;
+    initGCode();
+    initMotion();
+    kinematics.init();
+    nativeTimerInterrupt = runsOnATimer;
+}
+
+void loop(){}
+
+static double secondsSince(const std::chrono::steady_clock::time_point& start){
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void report(const char* name, double seconds, unsigned long calls){
+    printf("%-32s %10lu calls %12.1f ns/call\n", name, calls, seconds * 1e9 / calls);
+}
+
+static std::vector<std::string> testPattern(){
+    /*
+    A spiral of short moves with a change of depth every lap, much like the
+    output of a CAM program pocketing a circle
+    */
+    std::vector<std::string> lines;
+    char line[EXPGCODELINE];
+    lines.push_back("G21");
+    lines.push_back("G90");
+    lines.push_back("G0 Z5");
+    lines.push_back("G0 X0 Y0");
+    for (int lap = 0; lap < 10; lap++){
+        snprintf(line, sizeof(line), "G1 Z%.3f F300", -0.5 * (lap + 1));
+        lines.push_back(line);
+        for (int i = 0; i < 360; i += 2){
+            float radius = 20 + 20 * lap + i / 18.0;
+            snprintf(line, sizeof(line), "G1 X%.3f Y%.3f F1000", radius * cos(i * M_PI / 180), radius * sin(i * M_PI / 180));
+            lines.push_back(line);
+        }
+    }
+    lines.push_back("G0 Z5");
+    lines.push_back("G0 X0 Y0");
+    return lines;
+}
+
+static bool readGcodeFile(const char* fileName, std::vector<std::string>& lines){
+    FILE* file = fopen(fileName, "r");
+    if (file == NULL){
+        return false;
+    }
+    char line[256];
+    while (fgets(line, sizeof(line), file)){
+        std::string gcode(line);
+        while (!gcode.empty() && (gcode.back() == '\n' || gcode.back() == '\r')){
+            gcode.pop_back();
+        }
+        if (!gcode.empty() && gcode.size() < EXPGCODELINE){
+            lines.push_back(gcode);
+        }
+    }
+    fclose(file);
+    return true;
+}
+
+static void benchmarkKinematics(const char* name){
+    const int   steps = 40;
+    const float xStep = 2 * kinematics.halfWidth  / steps;
+    const float yStep = 2 * kinematics.halfHeight / steps;
+    float aChainLength;
+    float bChainLength;
+    float x;
+    float y;
+    char  label[40];
+
+    unsigned long calls = 0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int repeat = 0; repeat < 10; repeat++){
+        for (int i = 0; i <= steps; i++){
+            for (int j = 0; j <= steps; j++){
+                kinematics.inverse(-kinematics.halfWidth + i * xStep, -kinematics.halfHeight + j * yStep, &aChainLength, &bChainLength);
+                sink = aChainLength + bChainLength;
+                calls++;
+            }
+        }
+    }
+    snprintf(label, sizeof(label), "inverse() %s", name);
+    report(label, secondsSince(start), calls);
+
+    #if KINEMATICSCACHE > 0
+      //build the chain length cache the way loop() does while idle, then time it
+      const unsigned long cachePoints = KINEMATICSCACHEROWS * KINEMATICSCACHECOLS + (KINEMATICSCACHEROWS - 1) * (KINEMATICSCACHECOLS - 1);
+      calls = 0;
+      start = std::chrono::steady_clock::now();
+      while (kinematics.cacheError < 0 && calls < cachePoints){
+          kinematics.updateCache();
+          calls++;
+      }
+      if (kinematics.cacheError < 0){
+          printf("%-32s %10s\n", "chain length cache", "not built");
+      }
+      else {
+          snprintf(label, sizeof(label), "updateCache() %s", name);
+          report(label, secondsSince(start), calls);
+          printf("%-32s %10.4f mm from the exact solution at most%s\n", "chain length cache", kinematics.cacheError,
+                 kinematics.cacheError <= KINEMATICSCACHEMAXERROR ? "" : ", not used");
+      }
+      if (kinematics.cacheError >= 0 && kinematics.cacheError <= KINEMATICSCACHEMAXERROR){
+          calls = 0;
+          start = std::chrono::steady_clock::now();
+          for (int repeat = 0; repeat < 10; repeat++){
+              for (int i = 0; i <= steps; i++){
+                  for (int j = 0; j <= steps; j++){
+                      kinematics.inverse(-kinematics.halfWidth + i * xStep, -kinematics.halfHeight + j * yStep, &aChainLength, &bChainLength);
+                      sink = aChainLength + bChainLength;
+                      calls++;
+                  }
+              }
+          }
+          snprintf(label, sizeof(label), "inverse() %s cached", name);
+          report(label, secondsSince(start), calls);
+      }
+    #endif
+
+    //forward() is much slower, so only a row across the middle of the sheet,
+    //guessing 10mm away from the answer like the position reports do
+    calls = 0;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i <= steps; i++){
+        float xTarget = -0.9 * kinematics.halfWidth + 1.8 * i * kinematics.halfWidth / steps;
+        kinematics.inverse(xTarget, 0, &aChainLength, &bChainLength);
+        kinematics.forward(aChainLength, bChainLength, &x, &y, xTarget + 10, 10);
+        sink = x + y;
+        calls++;
+    }
+    snprintf(label, sizeof(label), "forward() %s", name);
+    report(label, secondsSince(start), calls);
+}
+
+static int baselineFindEndOfNumber(const String& textString, const int& index){
+    // findEndOfNumber() as it was before parseGcodeWords(), for comparison
+    unsigned int i = index;
+    while (i < textString.length()){
+        if(isDigit(textString[i]) or isPunct(textString[i])){
+            i++;
+        }
+        else{
+            return i;
+        }
+    }
+    return i;
+}
+
+static float baselineExtractGcodeValue(const String& readString, char target, const float& defaultReturn){
+    // extractGcodeValue() as it was before parseGcodeWords(), for comparison
+    int begin           =  readString.indexOf(target);
+    int end             =  baselineFindEndOfNumber(readString,begin+1);
+    String numberAsString  =  readString.substring(begin+1,end);
+    float numberAsFloat   =  numberAsString.toFloat();
+    if (begin == -1){
+        return defaultReturn;
+    }
+    return numberAsFloat;
+}
+
+static void benchmarkParser(const std::vector<std::string>& lines){
+    std::vector<String> strings;
+    for (size_t i = 0; i < lines.size(); i++){
+        strings.push_back(String(lines[i].c_str()));
+    }
+    const char letters[] = "GXYZFIJ";
+
+    unsigned long calls = 0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int repeat = 0; repeat < 20; repeat++){
+        for (size_t i = 0; i < strings.size(); i++){
+            for (size_t j = 0; j < sizeof(letters) - 1; j++){
+                sink = extractGcodeValue(strings[i], letters[j], 0);
+                calls++;
+            }
+        }
+    }
+    report("extractGcodeValue()", secondsSince(start), calls);
+
+    gcodeWords_t words;
+    calls = 0;
+    start = std::chrono::steady_clock::now();
+    for (int repeat = 0; repeat < 20; repeat++){
+        for (size_t i = 0; i < strings.size(); i++){
+            parseGcodeWords(strings[i], words);
+            sink = words.value[0];
+            calls++;
+        }
+    }
+    report("parseGcodeWords()", secondsSince(start), calls);
+
+    //every word the G1 and G2 handlers look for, read from each line the way it was done
+    //before parseGcodeWords() and the way it is done now
+    start = std::chrono::steady_clock::now();
+    for (int repeat = 0; repeat < 20; repeat++){
+        for (size_t i = 0; i < strings.size(); i++){
+            for (size_t j = 0; j < sizeof(letters) - 1; j++){
+                sink = baselineExtractGcodeValue(strings[i], letters[j], 0);
+            }
+        }
+    }
+    double before = secondsSince(start);
+    start = std::chrono::steady_clock::now();
+    for (int repeat = 0; repeat < 20; repeat++){
+        for (size_t i = 0; i < strings.size(); i++){
+            parseGcodeWords(strings[i], words);
+            for (size_t j = 0; j < sizeof(letters) - 1; j++){
+                sink = gcodeWordValue(words, letters[j], 0);
+            }
+        }
+    }
+    double after = secondsSince(start);
+    printf("%-32s %10.0f lines/s before, %.0f lines/s after\n", "gcode word parsing",
+        20 * strings.size() / before, 20 * strings.size() / after);
+}
+
+template <class Controller>
+static void benchmarkCompute(const char* name){
+    /*
+    Times Compute() of a motor speed PID loop with the default gains, the
+    checks compare how the floating and fixed point controllers move the motor
+    */
+    volatile double speed = 0, pwm = 0, targetSpeed = 10;
+    float kpV = 5, kiV = 0.1, kdV = 0.28, one = 1;
+    Controller speedPID;
+    speedPID.setup(&speed, &pwm, &targetSpeed, &kpV, &kiV, &kdV, &one, DIRECT);
+    speedPID.SetOutputLimits(-255, 255);
+    speedPID.SetSampleTime(VELOCITYLOOPINTERVAL / 1000);
+    speedPID.SetMode(AUTOMATIC);
+
+    const unsigned long calls = 1000000;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (unsigned long i = 0; i < calls; i++){
+        speed = (i & 63) * 0.25;
+        speedPID.Compute();
+    }
+    report(name, secondsSince(start), calls);
+}
+
+static void benchmarkPID(){
+    benchmarkCompute<PID>("PID::Compute()");
+    benchmarkCompute<FixedPID>("FixedPID::Compute()");
+
+    //the position loop of an axis, including reading the encoder, in the
+    //units chosen by STEPPOSITIONPID
+    const unsigned long calls = 1000000;
+    leftAxis.attach();
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (unsigned long i = 0; i < calls; i++){
+        leftAxis.motorGearboxEncoder.encoderSnapshot.position = i & 1023;
+        leftAxis.computePID();
+    }
+    report("Axis::computePID()", secondsSince(start), calls);
+    leftAxis.detach();
+}
+
+static void profileMove(const char* name, const float& distance, const float& MMPerMin, const float& acceleration){
+    /*
+    Works out the setpoints of a single axis move the way singleAxisMove() does and
+    reports how long it takes and the largest change in speed between two of them
+    */
+    float speed = 0;
+    float distanceTraveled = 0;
+    float largestChange = 0;
+    unsigned long steps = 0;
+    while (distanceTraveled < distance){
+        float lastSpeed = speed;
+        speed = motionProfileSpeed(speed, distance - distanceTraveled, MMPerMin / 60.0, acceleration);
+        distanceTraveled += speed * LOOPINTERVAL / 1000000.0;
+        if (fabs(speed - lastSpeed) > largestChange){
+            largestChange = fabs(speed - lastSpeed);
+        }
+        steps++;
+    }
+    if (speed > largestChange){
+        largestChange = speed;   // it stops dead after the last step
+    }
+    printf("%-32s %10.2f s, speed changes by %.3f mm/s a step at most\n", name,
+        steps * LOOPINTERVAL / 1000000.0, largestChange);
+}
+
+static void benchmarkProfile(){
+    /*
+    Compares a calibration move with and without an acceleration limit
+    */
+    profileMove("move without acceleration", 100, sysSettings.maxFeed, 0);
+    profileMove("move at chainAcceleration", 100, sysSettings.maxFeed, sysSettings.chainAcceleration);
+}
+
+static void benchmarkFile(const std::vector<std::string>& lines){
+    /*
+    Sends every line to the Firmware through Serial, waiting for room in the
+    incoming buffer like Ground Control does, and runs the main loop until the
+    last move is finished
+    */
+    setup();
+    pidTicks = 0;
+    size_t nextLine = 0;
+    std::string line;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    while (!sys.stop){
+        if (nextLine < lines.size() && Serial.available() == 0){
+            line = lines[nextLine] + "\n";
+            if (incSerialBuffer.spaceAvailable() > (int)line.size()){
+                Serial.feed(line.c_str());
+                nextLine++;
+            }
+        }
+        else if (nextLine == lines.size() && incSerialBuffer.numberOfLines() == 0 && plannerIsEmpty() && motionSetpointQueueEmpty()){
+            break;
+        }
+        gcodeExecuteLoop();
+        executePlannedMoves();
+        execSystemRealtime();
+    }
+    double seconds = secondsSince(start);
+
+    report("gcode lines", seconds, nextLine);
+    report("setpoints", seconds, pidTicks);
+    printf("%-32s %10.0f lines/s, %.1f s of machine time in %.3f s\n", "file throughput",
+        nextLine / seconds, pidTicks * LOOPINTERVAL / 1000000.0, seconds);
+    if (sys.stop){
+        printf("stopped early after line %lu\n", (unsigned long)nextLine);
+    }
+}
+
+int main(int argc, char* argv[]){
+    std::vector<std::string> lines;
+    if (argc > 1){
+        if (!readGcodeFile(argv[1], lines)){
+            printf("could not read %s\n", argv[1]);
+            return 1;
+        }
+    }
+    else {
+        lines = testPattern();
+    }
+
+    Serial.output = NULL;   // the Firmware's replies would drown out the results
+    setup();
+    if (runChecks() > 0){
+        return 1;
+    }
+    setup();
+
+    sysSettings.kinematicsType = 1;
+    kinematics.recomputeGeometry();
+    benchmarkKinematics("quadrilateral");
+    sysSettings.kinematicsType = 2;
+    kinematics.recomputeGeometry();
+    benchmarkKinematics("triangular");
+
+    benchmarkParser(lines);
+    benchmarkPID();
+    benchmarkProfile();
+    benchmarkFile(lines);
+    return 0;
+}
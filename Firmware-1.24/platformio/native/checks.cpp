@@ -0,0 +1,535 @@
+/*This file is part of the Maslow Control Software.
+    The Maslow Control Software is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    Maslow Control Software is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with the Maslow Control Software.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2014-2017 Bar Smith*/
+
+// Checks that the parts of the Firmware which can go wrong without anything
+// looking wrong on the machine still do what they should.  They are run by the
+// native program before the benchmarks, which stops if any of them fail.
+
+#include <stddef.h>
+#include <algorithm>
+#include <deque>
+#include <random>
+#include <thread>
+#include <vector>
+#include "Maslow.h"
+#include <EEPROM.h>
+#include "checks.h"
+
+static int failures = 0;
+
+static void check(const char* name, const bool& passed){
+    printf("%-32s %s\n", name, passed ? "ok" : "FAILED");
+    if (!passed){
+        failures++;
+    }
+}
+
+static bool checkSettingsReload(){
+    /*
+    A changed setting has to be loaded again after a reset, starting from a blank
+    EEPROM and from settings which have been wiped
+    */
+    bool passed = true;
+    for (byte pass = 0; pass < 2; pass++){
+        settingsWipe(pass == 0 ? SETTINGS_RESTORE_ALL : SETTINGS_RESTORE_SETTINGS);
+        settingsLoadFromEEprom();
+        settingsStoreGlobalSetting(21, 1500);
+        settingsFlush();
+        settingsLoadFromEEprom();
+        passed = passed && sysSettings.KpPos == 1500;
+    }
+    settingsWipe(SETTINGS_RESTORE_ALL);
+    settingsLoadFromEEprom();
+    return passed;
+}
+
+static bool checkSettingsVersion5(){
+    /*
+    Settings saved by version 5, before chainAcceleration and zAcceleration were
+    added, have to be kept on upgrade with the two new settings at their
+    defaults, and still be there after the next reset
+    */
+    settingsWipe(SETTINGS_RESTORE_ALL);
+    settingsReset();
+    sysSettings.KpPos = 1500;
+    const unsigned int length = offsetof(settings_t, chainAcceleration);
+    for (unsigned int i = 0; i < length; i++){
+        EEPROM.write(340 + i, ((const byte*)&sysSettings)[i]);
+    }
+    EEPROM.write(340 + length, EEPROMVALIDDATA);
+    EEPROM.write(300, 5);
+    EEPROM.write(301, EEPROMVALIDDATA);
+
+    bool passed = true;
+    for (byte pass = 0; pass < 2; pass++){
+        settingsLoadFromEEprom();
+        settingsFlush();
+        passed = passed && sysSettings.KpPos == 1500 &&
+            sysSettings.chainAcceleration == 100 && sysSettings.zAcceleration == 10;
+    }
+    passed = passed && EEPROM.read(300) == SETTINGSVERSION;
+    settingsWipe(SETTINGS_RESTORE_ALL);
+    settingsLoadFromEEprom();
+    return passed;
+}
+
+static bool checkReadFloat(){
+    /*
+    readFloat() has to agree with the C library on numbers of every length,
+    including ones with more digits than fit in a long
+    */
+    const char* numbers[] = {"0", "-1", "12.5", "-0.001", "1234.5678", "0.000000000123456789",
+                             "123456789", "1234567890", "-98765432101.25", "12345678901234567890"};
+    for (byte i = 0; i < sizeof(numbers) / sizeof(numbers[0]); i++){
+        byte  index = 0;
+        float value = 0;
+        readFloat(numbers[i], index, value);
+        double expected = atof(numbers[i]);
+        if (fabs(value - expected) > fabs(expected) * 1e-6){
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool checkFixedPIDSaturates(){
+    /*
+    FixedPID has to push its output to the limit, not wrap around, when the error
+    and gains are far too large for 16.16
+    */
+    volatile double input = 0;
+    volatile double output = 0;
+    volatile double setpoint = 0;
+    float Kp = 30000;
+    float Ki = 30000;
+    float Kd = 300;
+    float pOn = 0.5;
+    FixedPID pid;
+    pid.setup(&input, &output, &setpoint, &Kp, &Ki, &Kd, &pOn, DIRECT);
+    pid.SetOutputLimits(-255, 255);
+    pid.SetSampleTime(10);
+    pid.SetMode(AUTOMATIC);
+    bool passed = true;
+    const double targets[] = {30000, -30000, 20000, -40000};
+    for (byte i = 0; i < 4; i++){
+        setpoint = targets[i];
+        input = -targets[i];
+        for (byte j = 0; j < 3; j++){
+            pid.Compute();
+            passed = passed && output == ((targets[i] > 0) ? 255 : -255);
+        }
+    }
+    return passed;
+}
+
+template <class Controller>
+static void stepResponse(std::vector<double>& positions, const float& unitsPerRotation = 1){
+    /*
+    Runs a position and a speed PID loop, with the default gains and the
+    timing of runsOnATimer(), against a motor which reaches its 20 RPM full
+    speed in about 50ms and is asked to turn a tenth of a rotation.  The
+    position loop works in unitsPerRotation, with its gains scaled to match,
+    the way Axis does with STEPPOSITIONPID.
+    */
+    volatile double position = 0, targetPosition = 0.1 * unitsPerRotation, targetSpeed = 0;
+    volatile double speed = 0, pwm = 0;
+    float kpPos = 1300 / unitsPerRotation, kiPos = 0, kdPos = 34 / unitsPerRotation;
+    float kpV = 5, kiV = 0.1, kdV = 0.28, one = 1;
+    Controller positionPID;
+    Controller speedPID;
+    positionPID.setup(&position, &targetSpeed, &targetPosition, &kpPos, &kiPos, &kdPos, &one, DIRECT);
+    positionPID.SetOutputLimits(-20, 20);
+    positionPID.SetSampleTime(LOOPINTERVAL / 1000);
+    positionPID.SetMode(AUTOMATIC);
+    speedPID.setup(&speed, &pwm, &targetSpeed, &kpV, &kiV, &kdV, &one, DIRECT);
+    speedPID.SetOutputLimits(-255, 255);
+    speedPID.SetSampleTime(VELOCITYLOOPINTERVAL / 1000);
+    speedPID.SetMode(AUTOMATIC);
+
+    const double dt = VELOCITYLOOPINTERVAL / 1000000.0;
+    positions.clear();
+    for (int tick = 0; tick < 1000000 / VELOCITYLOOPINTERVAL; tick++){
+        if (tick % VELOCITYLOOPS == 0){
+            positionPID.Compute();
+        }
+        speedPID.Compute();
+        speed    += (pwm * 20 / 255 - speed) * dt / 0.05;
+        position += speed * dt / 60 * unitsPerRotation;
+        positions.push_back(position / unitsPerRotation);
+    }
+}
+
+static bool checkStepResponses(){
+    /*
+    The fixed point controller, and the position loop run in encoder steps, have
+    to move the motor the same way as the floating point controller in rotations,
+    to within 0.0001 of a rotation, a few thousandths of a mm of chain, over a
+    move which gets most of the way in the second simulated
+    */
+    std::vector<double> floating;
+    std::vector<double> fixed;
+    std::vector<double> steps;
+    stepResponse<PID>(floating);
+    stepResponse<FixedPID>(fixed);
+    stepResponse<PID>(steps, sysSettings.encoderSteps);
+
+    double largestFixed = 0;
+    double largestSteps = 0;
+    for (size_t i = 0; i < floating.size(); i++){
+        if (fabs(floating[i] - fixed[i]) > largestFixed){
+            largestFixed = fabs(floating[i] - fixed[i]);
+        }
+        if (fabs(floating[i] - steps[i]) > largestSteps){
+            largestSteps = fabs(floating[i] - steps[i]);
+        }
+    }
+    printf("%-32s %10.6f rotations apart at most, ending at %.6f and %.6f\n", "fixed point step response",
+        largestFixed, floating.back(), fixed.back());
+    printf("%-32s %10.6f rotations apart at most, ending at %.6f and %.6f\n", "step count step response",
+        largestSteps, floating.back(), steps.back());
+    return floating.back() > 0.05 && largestFixed < 0.0001 && largestSteps < 0.0001;
+}
+
+static bool checkRingBuffer(){
+    /*
+    Runs a RingBuffer and a std::deque side by side through a long random mix of
+    writes, reads and line reads, long enough to wrap around the buffer many times
+    and to overflow it, and checks that they always agree
+    */
+    RingBuffer buffer;
+    std::deque<char> model;
+    std::mt19937 random(1);
+    const char letters[] = "G01XYZ.-\n\n?";
+    long overflows = 0;
+    for (long i = 0; i < 200000; i++){
+        //take turns at filling the buffer up and emptying it out
+        int writes = ((i / 1000) % 2 == 0) ? 90 : 30;
+        int action = random() % 100;
+        if (action < writes){
+            char letter = letters[random() % (sizeof(letters) - 1)];
+            int overflow = buffer.write(letter);
+            if (letter == '?'){
+                if (overflow != 0) return false;
+            }
+            else if ((int)model.size() == INCBUFFERLENGTH - 1){
+                if (overflow != 1) return false;
+                overflows++;
+            }
+            else {
+                if (overflow != 0) return false;
+                model.push_back(letter);
+            }
+        }
+        else if (action < writes + (100 - writes) / 2){
+            char letter = buffer.read();
+            char expected = '\0';
+            if (!model.empty()){
+                expected = model.front();
+                model.pop_front();
+            }
+            if (letter != expected) return false;
+        }
+        else if (action < 99){
+            //every other line is read into a char buffer, which may be too short for it
+            std::string expected;
+            std::deque<char>::iterator newline = std::find(model.begin(), model.end(), '\n');
+            if (newline != model.end()){
+                expected.assign(model.begin(), newline);
+                model.erase(model.begin(), newline + 1);
+            }
+            if (i % 2 == 0){
+                String line;
+                buffer.readLine(line);
+                if (expected != line.c_str()) return false;
+            }
+            else {
+                char line[INCBUFFERLENGTH];
+                int  size = 1 + random() % INCBUFFERLENGTH;
+                expected = expected.substr(0, size - 1);
+                if (buffer.readLine(line, size) != (int)expected.size() || expected != line) return false;
+            }
+        }
+        else {
+            buffer.empty();
+            model.clear();
+        }
+        if (buffer.length() != (int)model.size() ||
+            buffer.spaceAvailable() != INCBUFFERLENGTH - 1 - (int)model.size() ||
+            buffer.numberOfLines() != (int)std::count(model.begin(), model.end(), '\n')){
+            return false;
+        }
+    }
+
+    //the line gcodeExecuteLoop() runs is trimmed and in upper case
+    const char* text = " \tg1 x10.5 f300 \r\n";
+    buffer.empty();
+    for (const char* letter = text; *letter != '\0'; letter++){
+        buffer.write(*letter);
+    }
+    char line[INCBUFFERLENGTH];
+    return overflows > 0 && buffer.prettyReadLine(line, sizeof(line)) == 13 && strcmp(line, "G1 X10.5 F300") == 0;
+}
+
+// A record which can be told apart from one half written or half read
+typedef struct {
+    uint32_t sequence;
+    uint32_t copies[3];         // sequence times 1, 3 and 5
+} stressRecord_t;
+
+static bool checkSPSCRing(){
+    /*
+    Pushes a few million records through a small SPSCRing from one thread while
+    another pops them, and checks that every record comes out whole and in order.
+    The host is a different processor from the Mega but it only reorders memory
+    accesses where the compiler is allowed to, which is what the barriers stop.
+    */
+    static SPSCRing<stressRecord_t, 8> ring;
+    const uint32_t records = 4000000;
+    bool passed = true;
+
+    std::thread consumer([&](){
+        stressRecord_t record;
+        uint32_t expected = 0;
+        while (expected < records){
+            if (ring.pop(record)){
+                if (record.sequence != expected ||
+                    record.copies[0] != expected ||
+                    record.copies[1] != expected * 3 ||
+                    record.copies[2] != expected * 5){
+                    passed = false;
+                }
+                expected++;
+            }
+            else {
+                std::this_thread::yield();   //let the producer in if there is only one core
+            }
+        }
+    });
+    for (uint32_t i = 0; i < records; i++){
+        stressRecord_t record = {i, {i, i * 3, i * 5}};
+        while (!ring.push(record)){
+            std::this_thread::yield();
+        }
+    }
+    consumer.join();
+    return passed && ring.empty();
+}
+
+static void referenceTriangularInverse(double xTarget, double yTarget, double* aChainLength, double* bChainLength){
+    /*
+    The triangular inverse kinematics as they were before they were streamlined,
+    in double precision, for triangularInverse() to be compared against
+    */
+    double xCordOfMotor = sysSettings.distBetweenMotors / 2.0;
+    double yCordOfMotor = sysSettings.machineHeight / 2.0 + sysSettings.motorOffsetY;
+    double R = kinematics.R;
+
+    double Motor1Distance = sqrt(pow((-1*xCordOfMotor - xTarget),2)+pow((yCordOfMotor - yTarget),2));
+    double Motor2Distance = sqrt(pow((xCordOfMotor - xTarget),2)+pow((yCordOfMotor - yTarget),2));
+
+    double Chain1Angle;
+    double Chain2Angle;
+    double Chain1AroundSprocket;
+    double Chain2AroundSprocket;
+    if(sysSettings.chainOverSprocket == 1){
+        Chain1Angle = asin((yCordOfMotor - yTarget)/Motor1Distance) + asin(R/Motor1Distance);
+        Chain2Angle = asin((yCordOfMotor - yTarget)/Motor2Distance) + asin(R/Motor2Distance);
+        Chain1AroundSprocket = R * Chain1Angle;
+        Chain2AroundSprocket = R * Chain2Angle;
+    }
+    else{
+        Chain1Angle = asin((yCordOfMotor - yTarget)/Motor1Distance) - asin(R/Motor1Distance);
+        Chain2Angle = asin((yCordOfMotor - yTarget)/Motor2Distance) - asin(R/Motor2Distance);
+        Chain1AroundSprocket = R * (3.14159 - Chain1Angle);
+        Chain2AroundSprocket = R * (3.14159 - Chain2Angle);
+    }
+
+    double Chain1Straight = sqrt(pow(Motor1Distance,2)-pow(R,2));
+    double Chain2Straight = sqrt(pow(Motor2Distance,2)-pow(R,2));
+    Chain1Straight *= (1 + ((sysSettings.chainSagCorrection / 1000000000000.0) * pow(cos(Chain1Angle),2) * pow(Chain1Straight,2) * pow((tan(Chain2Angle) * cos(Chain1Angle)) + sin(Chain1Angle),2)));
+    Chain2Straight *= (1 + ((sysSettings.chainSagCorrection / 1000000000000.0) * pow(cos(Chain2Angle),2) * pow(Chain2Straight,2) * pow((tan(Chain1Angle) * cos(Chain2Angle)) + sin(Chain2Angle),2)));
+
+    *aChainLength = Chain1AroundSprocket + Chain1Straight - sysSettings.rotationDiskRadius;
+    *bChainLength = Chain2AroundSprocket + Chain2Straight - sysSettings.rotationDiskRadius;
+}
+
+static bool checkTriangularInverse(){
+    /*
+    triangularInverse() has to match the double precision reference on a 2mm grid
+    over the whole sheet, with the chain over and under the sprocket and several
+    amounts of chain sag correction.  The limit is the KINEMATICSFASTTRIG error in
+    Config.h.
+    */
+    const float chainSagCorrection = sysSettings.chainSagCorrection;
+    const byte  chainOverSprocket  = sysSettings.chainOverSprocket;
+    const float sagCorrections[] = {0, 20, 60};
+    double worst = 0;
+    for (byte sprocket = 1; sprocket <= 2; sprocket++){
+        sysSettings.chainOverSprocket = sprocket;
+        for (byte sag = 0; sag < 3; sag++){
+            sysSettings.chainSagCorrection = sagCorrections[sag];
+            for (float x = -kinematics.halfWidth; x <= kinematics.halfWidth; x += 2){
+                for (float y = -kinematics.halfHeight; y <= kinematics.halfHeight; y += 2){
+                    float  aChainLength, bChainLength;
+                    double aReference, bReference;
+                    kinematics.triangularInverse(x, y, &aChainLength, &bChainLength);
+                    referenceTriangularInverse(x, y, &aReference, &bReference);
+                    worst = fmax(worst, fmax(fabs(aChainLength - aReference), fabs(bChainLength - bReference)));
+                }
+            }
+        }
+    }
+    sysSettings.chainSagCorrection = chainSagCorrection;
+    sysSettings.chainOverSprocket  = chainOverSprocket;
+    printf("%-32s %10.6f mm from the reference at most\n", "triangularInverse()", worst);
+    return worst < 0.0008;
+}
+
+#if KINEMATICSCACHE > 0
+static bool checkKinematicsCache(){
+    /*
+    The chain length cache has to be close enough to the exact solution to be used
+    on the default quadrilateral frame, which is what it is there to speed up
+    */
+    byte kinematicsType = sysSettings.kinematicsType;
+    sysSettings.kinematicsType = 1;
+    kinematics.recomputeGeometry();
+    for (int i = 0; i < KINEMATICSCACHEROWS * KINEMATICSCACHECOLS * 2 && kinematics.cacheError < 0; i++){
+        kinematics.updateCache();
+    }
+    bool passed = kinematics.cacheError >= 0 && kinematics.cacheError <= KINEMATICSCACHEMAXERROR;
+    sysSettings.kinematicsType = kinematicsType;
+    kinematics.recomputeGeometry();
+    return passed;
+}
+#endif
+
+static bool checkRealtimeAcknowledge(){
+    /*
+    '~' has to be acknowledged with an ok normally, but not in streaming mode where
+    the host counts every ok as a line taken out of the buffer
+    */
+    bool   passed = true;
+    FILE*  output = Serial.output;
+    for (byte streaming = 0; streaming < 2; streaming++){
+        char*  reply = NULL;
+        size_t replyLength = 0;
+        Serial.output = open_memstream(&reply, &replyLength);
+        sys.streaming = streaming;
+        Serial.feed("~\n");
+        readSerialCommands();
+        fclose(Serial.output);
+        passed = passed && (strstr(reply, "ok") != NULL) == !streaming;
+        free(reply);
+    }
+    Serial.output = output;
+    sys.streaming = false;
+    return passed;
+}
+
+static void runGcode(const char* line){
+    /*
+    Runs a line of gcode the way it would be sent by Ground Control and waits for
+    the machine to finish moving
+    */
+    String command = line;
+    interpretCommandString(command);
+    motionSynchronize();
+}
+
+static bool checkPlannedZ(){
+    /*
+    A move without a Z word has to keep z where the last move sent it, not where
+    the encoder has got to.  The native motors don't move, so the encoder stays
+    at 0 the whole time.
+    */
+    runGcode("G90");
+    runGcode("G1 Z-5 F300");
+    runGcode("G1 X20 F1000");
+    return fabs(zAxis.setpoint() + 5) < 0.001;
+}
+
+static bool checkSingleAxisMove(){
+    /*
+    singleAxisMove() has to leave the axis exactly on its target, even though the
+    setpoint queue is full when the last step is worked out
+    */
+    float leftTarget = leftAxis.read() + 10.37;
+    singleAxisMove(&leftAxis, leftTarget, 500);
+    singleAxisMove(&zAxis, -3.21, 40);
+    #if STEPPOSITIONPID > 0
+    //the setpoint is a whole number of encoder steps, so within half a step
+    return fabs(leftAxis.setpoint() - leftTarget) <= 0.5 * sysSettings.distPerRot / sysSettings.encoderSteps
+        && fabs(zAxis.setpoint() + 3.21) <= 0.5 * sysSettings.zDistPerRot / sysSettings.zEncoderSteps;
+    #else
+    return leftAxis.setpoint() == leftTarget && zAxis.setpoint() == (float)-3.21;
+    #endif
+}
+
+#if STEPPOSITIONPID > 0
+static bool checkStepSetpoint(){
+    /*
+    With STEPPOSITIONPID the setpoint is a count of encoder steps, which has to stay
+    exact even where a float could not hold it
+    */
+    const long farAway = 20000001L;     // more than a float holds exactly
+    long start = leftAxis.steps();
+    leftAxis.setSteps(farAway);
+    bool passed = leftAxis.error() == 0;
+    leftAxis.motorGearboxEncoder.encoder.write(farAway + 1);
+    passed = passed && leftAxis.error() == sysSettings.distPerRot / sysSettings.encoderSteps;
+    leftAxis.setSteps(start);
+    return passed;
+}
+#endif
+
+static bool checkStatusFrameInterval(){
+    /*
+    $F has to keep the interval between status frames within what
+    sys.statusFrameInterval can hold, however large the number sent
+    */
+    String command = "$F=100000";
+    bool passed = systemExecuteCmdstring(command) == STATUS_OK && sys.statusFrameInterval == MAXSTATUSFRAMEINTERVAL;
+    command = "$F=5";
+    passed = passed && systemExecuteCmdstring(command) == STATUS_OK && sys.statusFrameInterval == MINSTATUSFRAMEINTERVAL;
+    command = "$F=0";
+    passed = passed && systemExecuteCmdstring(command) == STATUS_OK && sys.statusFrameInterval == 0;
+    return passed;
+}
+
+int runChecks(){
+    /*
+    Runs every check and returns the number which failed
+    */
+    failures = 0;
+    check("settings survive a reload", checkSettingsReload());
+    check("version 5 settings are kept", checkSettingsVersion5());
+    check("readFloat() of long numbers", checkReadFloat());
+    check("FixedPID saturates", checkFixedPIDSaturates());
+    check("PID step responses agree", checkStepResponses());
+    check("triangular inverse kinematics", checkTriangularInverse());
+    #if KINEMATICSCACHE > 0
+    check("quadrilateral kinematics cache", checkKinematicsCache());
+    #endif
+    check("RingBuffer against std::deque", checkRingBuffer());
+    check("SPSCRing across two threads", checkSPSCRing());
+    check("$F status frame interval", checkStatusFrameInterval());
+    check("no ok for ~ while streaming", checkRealtimeAcknowledge());
+    check("moves keep the planned z", checkPlannedZ());
+    check("single axis moves end on target", checkSingleAxisMove());
+    #if STEPPOSITIONPID > 0
+    check("setpoint in whole steps", checkStepSetpoint());
+    #endif
+    return failures;
+}